@@ -0,0 +1,640 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <numeric>
+
+#include "paginator.h"
+
+using namespace std::string_literals;
+
+std::string GenerateWord(std::mt19937& generator, int max_length) {
+    const int length = std::uniform_int_distribution(1, max_length)(generator);
+    std::string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(std::uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length) {
+    std::vector<std::string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    words.erase(unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                          int word_count, double minus_prob) {
+    std::string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (std::uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[std::uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                         int query_count, int max_word_count) {
+    std::vector<std::string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+    return queries;
+}
+
+std::vector<std::string> GenerateZipfQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                             int query_count, int word_count) {
+    std::vector<double> weights(dictionary.size());
+    for (size_t i = 0; i < weights.size(); ++i) {
+        weights[i] = 1.0 / (i + 1);
+    }
+    std::discrete_distribution<size_t> word_distribution(weights.begin(), weights.end());
+    std::vector<std::string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        std::string query;
+        for (int j = 0; j < word_count; ++j) {
+            if (!query.empty()) {
+                query.push_back(' ');
+            }
+            query += dictionary[word_distribution(generator)];
+        }
+        queries.push_back(std::move(query));
+    }
+    return queries;
+}
+
+std::vector<std::string> GenerateTopicDocuments(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                                int document_count, int word_count, int topic_count,
+                                                double topic_share) {
+    const size_t topic_size = std::max<size_t>(1, dictionary.size() / topic_count);
+    std::uniform_int_distribution<int> topic_distribution(0, topic_count - 1);
+    std::uniform_int_distribution<size_t> topic_word_distribution(0, topic_size - 1);
+    std::uniform_int_distribution<size_t> word_distribution(0, dictionary.size() - 1);
+    std::bernoulli_distribution is_on_topic(topic_share);
+    std::vector<std::string> documents;
+    documents.reserve(document_count);
+    for (int i = 0; i < document_count; ++i) {
+        const size_t topic_begin = topic_distribution(generator) * topic_size % dictionary.size();
+        std::string document;
+        for (int j = 0; j < word_count; ++j) {
+            if (!document.empty()) {
+                document.push_back(' ');
+            }
+            const size_t word = is_on_topic(generator)
+                                ? (topic_begin + topic_word_distribution(generator)) % dictionary.size()
+                                : word_distribution(generator);
+            document += dictionary[word];
+        }
+        documents.push_back(std::move(document));
+    }
+    return documents;
+}
+
+SearchServer MakeBenchmarkServer(const std::vector<std::string>& dictionary, const std::vector<std::string>& documents) {
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    return search_server;
+}
+
+// Same documents in the same order, relevances compared bit for bit
+static bool AreSameResults(const std::vector<std::vector<Document>>& lhs,
+                           const std::vector<std::vector<Document>>& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                      [](const auto& lhs_documents, const auto& rhs_documents) {
+                          return std::equal(lhs_documents.begin(), lhs_documents.end(),
+                                            rhs_documents.begin(), rhs_documents.end(),
+                                            [](const Document& l, const Document& r) {
+                                                return l.id == r.id && l.relevance == r.relevance
+                                                       && l.rating == r.rating;
+                                            });
+                      });
+}
+
+void BenchmarkExecutionPolicies(std::mt19937& generator) {
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 10'000, 70);
+    const SearchServer search_server = MakeBenchmarkServer(dictionary, documents);
+    const auto queries = GenerateQueries(generator, dictionary, 100, 70);
+    TEST(seq);
+    TEST(par);
+}
+
+void BenchmarkAutocomplete(std::mt19937& generator) {
+    using namespace std::chrono;
+
+    const auto dictionary = GenerateDictionary(generator, 50'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 10'000, 70);
+    SearchServer search_server = MakeBenchmarkServer(dictionary, documents);
+
+    std::vector<std::string> prefixes;
+    for (int i = 0; i < 10'000; ++i) {
+        const std::string& word = dictionary[std::uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+        prefixes.push_back(word.substr(0, std::uniform_int_distribution<size_t>(1, 3)(generator)));
+    }
+
+    size_t total_suggestions = 0;
+    const auto start_time = steady_clock::now();
+    for (const std::string& prefix : prefixes) {
+        total_suggestions += search_server.Autocomplete(prefix).size();
+    }
+    const auto duration = duration_cast<nanoseconds>(steady_clock::now() - start_time);
+
+    const auto stats = search_server.GetTermDictionaryStats();
+    // Key part of the inverted index: map node, string_view key and the nested map header
+    const size_t map_key_bytes = stats.term_count * (4 * sizeof(void*) + sizeof(std::string_view)
+                                                     + sizeof(std::map<int, double>));
+    std::cout << "Autocomplete: "s << duration.count() / prefixes.size() << " ns per prefix, "s
+              << total_suggestions << " suggestions"s << std::endl;
+    // The dictionary is kept in addition to the inverted index, not instead of it
+    const size_t dictionary_bytes = stats.frozen_bytes + stats.pending_bytes + stats.id_table_bytes;
+    std::cout << "Term dictionary: "s << stats.term_count << " terms, "s
+              << dictionary_bytes << " extra bytes next to "s << map_key_bytes
+              << " bytes of map keys still used for exact lookups, "s
+              << dictionary_bytes + map_key_bytes << " bytes in total"s << std::endl;
+}
+
+void BenchmarkRankings(std::mt19937& generator) {
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 10'000, 70);
+    SearchServer search_server = MakeBenchmarkServer(dictionary, documents);
+    const auto queries = GenerateQueries(generator, dictionary, 1'000, 10);
+
+    const auto run = [&](std::string_view mark, const auto& ranking) {
+        LOG_DURATION(mark);
+        double total_relevance = 0;
+        for (const std::string& query : queries) {
+            for (const auto& document : search_server.FindTopDocuments(std::execution::seq, ranking, query,
+                                                                       DocumentStatus::ACTUAL)) {
+                total_relevance += document.relevance;
+            }
+        }
+        std::cout << total_relevance << std::endl;
+    };
+    run("TF-IDF"s, TfIdfRanking{});
+    run("BM25"s, Bm25Ranking{});
+    run("BM25 + rating"s, RatingBoostedRanking<Bm25Ranking>{});
+}
+
+void BenchmarkBatchQueries(std::mt19937& generator) {
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 10);
+    SearchServer search_server = MakeBenchmarkServer(dictionary, documents);
+    const auto queries = GenerateZipfQueries(generator, dictionary, 10'000, 5);
+
+    std::vector<std::vector<Document>> expected;
+    std::vector<std::vector<Document>> batched;
+    {
+        LOG_DURATION("ProcessQueries"s);
+        expected = ProcessQueries(search_server, queries);
+    }
+    {
+        LOG_DURATION("ProcessQueriesBatched"s);
+        batched = ProcessQueriesBatched(search_server, queries);
+    }
+    std::cout << "Batched results "s << (AreSameResults(expected, batched) ? "match"s : "DIFFER"s) << std::endl;
+}
+
+void BenchmarkImpactOrderedSearch(std::mt19937& generator) {
+    const auto dictionary = GenerateDictionary(generator, 2'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 50'000, 30);
+    SearchServer search_server = MakeBenchmarkServer(dictionary, documents);
+    const auto queries = GenerateZipfQueries(generator, dictionary, 2'000, 3);
+
+    const auto run = [&](std::string_view mark) {
+        LOG_DURATION(mark);
+        std::vector<std::vector<Document>> results;
+        results.reserve(queries.size());
+        for (const std::string& query : queries) {
+            results.push_back(search_server.FindTopDocuments(std::execution::seq, query));
+        }
+        return results;
+    };
+    const auto expected = run("Term-at-a-time"s);
+    search_server.EnableImpactOrderedSearch();
+    const auto impact_ordered = run("Impact-ordered"s);
+
+    ImpactSearchStats total_stats;
+    for (const std::string& query : queries) {
+        const ImpactSearchStats stats = search_server.GetImpactSearchStats(query);
+        total_stats.postings_total += stats.postings_total;
+        total_stats.postings_touched += stats.postings_touched;
+    }
+    std::cout << "Postings touched: "s << total_stats.postings_touched << " of "s << total_stats.postings_total
+              << ", results "s << (AreSameResults(expected, impact_ordered) ? "match"s : "DIFFER"s) << std::endl;
+}
+
+void BenchmarkDocumentReordering(std::mt19937& generator) {
+    const auto dictionary = GenerateDictionary(generator, 5'000, 10);
+    const auto documents = GenerateTopicDocuments(generator, dictionary, 50'000, 20, 100, 0.8);
+    SearchServer search_server = MakeBenchmarkServer(dictionary, documents);
+    const auto queries = GenerateTopicDocuments(generator, dictionary, 2'000, 3, 100, 1.0);
+
+    const auto run = [&](std::string_view mark) {
+        LOG_DURATION(mark);
+        std::vector<std::vector<Document>> results;
+        results.reserve(queries.size());
+        for (const std::string& query : queries) {
+            results.push_back(search_server.FindTopDocuments(std::execution::seq, query));
+        }
+        return results;
+    };
+    const auto print_stats = [&search_server](std::string_view mark, const DocumentOrderStats& stats) {
+        std::cout << mark << ": "s << stats.gap_bytes << " bytes of gaps, "s
+                  << stats.average_gap_bits << " bits per gap, "s
+                  << stats.array_bytes << " bytes of ordinal arrays next to "s
+                  << search_server.GetMemoryStats().inverted_index.GetTotalBytes() << " bytes of inverted index"s
+                  << std::endl;
+    };
+    const auto expected = run("Id-keyed postings"s);
+    search_server.EnableDocumentOrdinals();
+    print_stats("Insertion order"s, search_server.GetDocumentOrderStats());
+    const auto in_id_order = run("Ordinals in id order"s);
+    {
+        LOG_DURATION("ReorderDocuments"s);
+        search_server.ReorderDocuments();
+    }
+    print_stats("Reordered"s, search_server.GetDocumentOrderStats());
+    const auto reordered = run("Reordered ordinals"s);
+    std::cout << "Results "s << (AreSameResults(expected, in_id_order) && AreSameResults(expected, reordered)
+                                  ? "match"s
+                                  : "DIFFER"s)
+              << std::endl;
+}
+
+void BenchmarkFilteredSearch(std::mt19937& generator) {
+    const auto dictionary = GenerateDictionary(generator, 5'000, 10);
+    const auto documents = GenerateTopicDocuments(generator, dictionary, 50'000, 20, 100, 0.8);
+    SearchServer search_server(dictionary[0]);
+    std::discrete_distribution<int> status_distribution({90, 4, 4, 2});
+    std::uniform_int_distribution<int> rating_distribution(-10, 10);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], static_cast<DocumentStatus>(status_distribution(generator)),
+                                  {rating_distribution(generator)});
+    }
+    const auto queries = GenerateTopicDocuments(generator, dictionary, 2'000, 3, 100, 1.0);
+
+    const auto run = [&](std::string_view mark, const auto& document_predicate) {
+        LOG_DURATION(mark);
+        std::vector<std::vector<Document>> results;
+        results.reserve(queries.size());
+        for (const std::string& query : queries) {
+            results.push_back(search_server.FindTopDocuments(std::execution::seq, query, document_predicate));
+        }
+        return results;
+    };
+    const auto is_banned = [](int /*document_id*/, DocumentStatus status, int /*rating*/) {
+        return status == DocumentStatus::BANNED;
+    };
+    const auto is_well_rated = [](int /*document_id*/, DocumentStatus /*status*/, int rating) {
+        return rating > 5;
+    };
+    const DocumentFilter banned = DocumentFilter::ForStatus(DocumentStatus::BANNED);
+    DocumentFilter well_rated;
+    well_rated.min_rating = 6;
+
+    const auto expected_banned = run("BANNED, lambda"s, is_banned);
+    const auto expected_well_rated = run("rating > 5, lambda"s, is_well_rated);
+    search_server.EnableDocumentOrdinals();
+    bool is_equal = AreSameResults(expected_banned, run("BANNED, filter over ordinals"s, banned))
+                    && AreSameResults(expected_well_rated, run("rating > 5, filter over ordinals"s, well_rated));
+    search_server.ReorderDocuments();
+    is_equal = AreSameResults(expected_banned, run("BANNED, filter over reordered ordinals"s, banned))
+               && AreSameResults(expected_well_rated, run("rating > 5, filter over reordered ordinals"s, well_rated))
+               && is_equal;
+    std::cout << "Results "s << (is_equal ? "match"s : "DIFFER"s) << std::endl;
+}
+
+bool BenchmarkMemoryFootprint(std::mt19937& generator) {
+    using namespace std::chrono;
+    // Inverted plus forward index bytes per posting, allocator overhead included
+    static constexpr double INDEX_BYTES_PER_POSTING_BUDGET = 160.0;
+
+    const auto dictionary = GenerateDictionary(generator, 5'000, 10);
+    const auto documents = GenerateTopicDocuments(generator, dictionary, 50'000, 20, 100, 0.8);
+    SearchServer search_server = MakeBenchmarkServer(dictionary, documents);
+
+    const auto print_stats = [](std::string_view mark, const MemoryStats& stats) {
+        std::cout << mark << ": "s << stats.GetTotalBytes() << " bytes, "s << stats.term_count << " terms, "s
+                  << stats.posting_count << " postings, "s << stats.average_posting_length
+                  << " postings per term"s << std::endl;
+        const auto print_structure = [](std::string_view name, const StructureMemory& memory) {
+            std::cout << "  "s << name << ": "s << memory.bytes << " + "s << memory.overhead_bytes
+                      << " overhead bytes in "s << memory.allocation_count << " blocks"s << std::endl;
+        };
+        print_structure("document texts"s, stats.document_texts);
+        print_structure("inverted index"s, stats.inverted_index);
+        print_structure("forward index"s, stats.forward_index);
+        print_structure("document data"s, stats.document_data);
+        print_structure("document ids"s, stats.document_ids);
+        const double index_bytes_per_posting =
+                stats.posting_count == 0
+                ? 0.0
+                : static_cast<double>(stats.inverted_index.GetTotalBytes() + stats.forward_index.GetTotalBytes())
+                  / stats.posting_count;
+        const bool is_within_budget = index_bytes_per_posting <= INDEX_BYTES_PER_POSTING_BUDGET;
+        std::cout << "  index bytes per posting: "s << index_bytes_per_posting
+                  << (is_within_budget ? ", within budget"s : ", OVER BUDGET"s) << std::endl;
+        return is_within_budget;
+    };
+    bool is_within_budget = print_stats("Full"s, search_server.GetMemoryStats());
+    for (size_t i = 0; i < documents.size(); i += 2) {
+        search_server.RemoveDocument(i);
+    }
+    is_within_budget = print_stats("Half removed"s, search_server.GetMemoryStats()) && is_within_budget;
+
+    static constexpr int CALL_COUNT = 1'000'000;
+    size_t checksum = 0;
+    const auto start_time = steady_clock::now();
+    for (int i = 0; i < CALL_COUNT; ++i) {
+        checksum += search_server.GetMemoryStats().posting_count;
+    }
+    const auto duration = duration_cast<nanoseconds>(steady_clock::now() - start_time);
+    std::cout << "GetMemoryStats: "s << duration.count() / CALL_COUNT << " ns per call ("s << checksum % 10
+              << ")"s << std::endl;
+    return is_within_budget;
+}
+
+void BenchmarkIngest(std::mt19937& generator) {
+    using namespace std::chrono;
+    const auto dictionary = GenerateDictionary(generator, 5'000, 10);
+    const auto documents = GenerateTopicDocuments(generator, dictionary, 50'000, 20, 100, 0.8);
+    const auto start_time = steady_clock::now();
+    const SearchServer search_server = MakeBenchmarkServer(dictionary, documents);
+    const auto duration = duration_cast<milliseconds>(steady_clock::now() - start_time);
+
+    const MemoryStats stats = search_server.GetMemoryStats();
+    std::cout << "Ingest: "s << duration.count() << " ms, "s
+              << documents.size() * 1000 / std::max<int64_t>(1, duration.count()) << " documents per second"s
+              << std::endl;
+    std::cout << "Inverted index: "s << stats.inverted_index.GetTotalBytes() << " bytes, forward index: "s
+              << stats.forward_index.GetTotalBytes() << " bytes for "s << stats.posting_count << " postings"s
+              << std::endl;
+}
+
+void BenchmarkLoad(std::mt19937& generator, const std::vector<std::string>& query_log) {
+    using namespace std::chrono;
+    static constexpr size_t BATCH_SIZE = 16;
+    static constexpr size_t WRITE_INTERVAL = 10;
+
+    const auto dictionary = GenerateDictionary(generator, 5'000, 10);
+    const auto documents = GenerateTopicDocuments(generator, dictionary, 20'000, 20, 100, 0.8);
+    SearchServer search_server = MakeBenchmarkServer(dictionary, documents);
+    const auto queries = query_log.empty() ? GenerateZipfQueries(generator, dictionary, 10'000, 3) : query_log;
+    std::vector<std::vector<std::string>> batches;
+    for (size_t i = 0; i < queries.size(); i += BATCH_SIZE) {
+        batches.emplace_back(queries.begin() + i, queries.begin() + std::min(i + BATCH_SIZE, queries.size()));
+    }
+
+    // Capacity of one client running back to back
+    static constexpr size_t CALIBRATION_COUNT = 200;
+    const auto start_time = steady_clock::now();
+    for (size_t i = 0; i < CALIBRATION_COUNT; ++i) {
+        search_server.FindTopDocuments(std::execution::seq, queries[i % queries.size()]);
+    }
+    const double capacity = CALIBRATION_COUNT / duration_cast<duration<double>>(steady_clock::now() - start_time).count();
+
+    LoadOptions options;
+    options.target_qps = 0.7 * capacity;
+    options.request_count = 2'000;
+    std::cout << "Target: "s << options.target_qps << " queries per second, "s << options.client_count
+              << " clients"s << std::endl;
+    std::cout << "seq: "s << RunLoad(options, [&](size_t i) {
+        search_server.FindTopDocuments(std::execution::seq, queries[i % queries.size()]);
+    }) << std::endl;
+    std::cout << "par: "s << RunLoad(options, [&](size_t i) {
+        search_server.FindTopDocuments(std::execution::par, queries[i % queries.size()]);
+    }) << std::endl;
+
+    LoadOptions batch_options = options;
+    batch_options.target_qps = options.target_qps / BATCH_SIZE;
+    batch_options.request_count = options.request_count / BATCH_SIZE;
+    std::cout << "ProcessQueries, "s << BATCH_SIZE << " queries per request: "s
+              << RunLoad(batch_options, [&](size_t i) {
+                     ProcessQueries(search_server, batches[i % batches.size()]);
+                 }) << std::endl;
+
+    // Writes alternate between adding a new document and removing the oldest one
+    LoadOptions mixed_options = options;
+    mixed_options.write_interval = WRITE_INTERVAL;
+    int next_document_id = static_cast<int>(documents.size());
+    int oldest_document_id = 0;
+    bool is_adding = true;
+    std::cout << "seq with 1 write per "s << WRITE_INTERVAL << " requests: "s
+              << RunLoad(mixed_options,
+                         [&](size_t i) {
+                             search_server.FindTopDocuments(std::execution::seq, queries[i % queries.size()]);
+                         },
+                         [&](size_t i) {
+                             if (is_adding) {
+                                 search_server.AddDocument(next_document_id++, documents[i % documents.size()],
+                                                           DocumentStatus::ACTUAL, {1, 2, 3});
+                             } else {
+                                 search_server.RemoveDocument(oldest_document_id++);
+                             }
+                             is_adding = !is_adding;
+                         }) << std::endl;
+}
+
+void BenchmarkParse(std::mt19937& generator) {
+    using namespace std::chrono;
+    // Distinct words only, so that every indexed word has short postings
+    auto dictionary = GenerateDictionary(generator, 20'000, 10);
+    std::sort(dictionary.begin(), dictionary.end());
+    dictionary.erase(std::unique(dictionary.begin(), dictionary.end()), dictionary.end());
+    std::shuffle(dictionary.begin(), dictionary.end(), generator);
+    const std::vector<std::string> stop_words(dictionary.begin(), dictionary.begin() + 100);
+    const std::vector<std::string> words(dictionary.begin() + 100, dictionary.end());
+    const auto documents = GenerateQueries(generator, words, 20'000, 10);
+    SearchServer search_server(stop_words);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    // Every fourth token is a stop word, a few are not indexed at all
+    std::vector<std::string> tokens;
+    for (int i = 0; i < 100'000; ++i) {
+        if (i % 4 == 0) {
+            tokens.push_back(stop_words[std::uniform_int_distribution<size_t>(0, stop_words.size() - 1)(generator)]);
+        } else if (i % 16 == 1) {
+            tokens.push_back(GenerateWord(generator, 10));
+        } else {
+            tokens.push_back(words[std::uniform_int_distribution<size_t>(0, words.size() - 1)(generator)]);
+        }
+    }
+
+    const auto measure = [&tokens](std::string_view mark, const auto& lookup) {
+        size_t found_count = 0;
+        const auto start_time = steady_clock::now();
+        for (int repeat = 0; repeat < 10; ++repeat) {
+            for (const std::string& token : tokens) {
+                found_count += lookup(token);
+            }
+        }
+        const auto duration = duration_cast<nanoseconds>(steady_clock::now() - start_time);
+        std::cout << mark << ": "s << static_cast<double>(duration.count()) / (10 * tokens.size())
+                  << " ns per token ("s << found_count / 10 << " found)"s << std::endl;
+    };
+    const std::set<std::string, std::less<>> stop_word_set(stop_words.begin(), stop_words.end());
+    const PerfectHash stop_word_hash(std::vector<std::string_view>(stop_words.begin(), stop_words.end()));
+    std::map<std::string_view, int> vocabulary;
+    for (const std::string& word : words) {
+        vocabulary.emplace(word, 0);
+    }
+    const PerfectHash vocabulary_hash(std::vector<std::string_view>(words.begin(), words.end()));
+    measure("Stop words, std::set"s, [&](std::string_view token) {
+        return stop_word_set.count(token) > 0;
+    });
+    measure("Stop words, perfect hash"s, [&](std::string_view token) {
+        return stop_word_hash.Find(token) != PerfectHash::NOT_FOUND;
+    });
+    measure("Stop word and term, std::set and std::map"s, [&](std::string_view token) {
+        return stop_word_set.count(token) == 0 && vocabulary.count(token) > 0;
+    });
+    measure("Stop word and term, perfect hashes"s, [&](std::string_view token) {
+        return stop_word_hash.Find(token) == PerfectHash::NOT_FOUND
+               && vocabulary_hash.Find(token) != PerfectHash::NOT_FOUND;
+    });
+
+    // The whole parse path, seen through searches whose words have short postings
+    std::vector<std::string> queries;
+    for (size_t i = 0; i + 20 <= tokens.size(); i += 20) {
+        std::string query;
+        for (size_t j = i; j < i + 20; ++j) {
+            if (!query.empty()) {
+                query.push_back(' ');
+            }
+            query += tokens[j];
+        }
+        queries.push_back(std::move(query));
+    }
+    const auto run = [&](std::string_view mark) {
+        std::vector<std::vector<Document>> results;
+        results.reserve(queries.size());
+        const auto start_time = steady_clock::now();
+        for (const std::string& query : queries) {
+            results.push_back(search_server.FindTopDocuments(std::execution::seq, query));
+        }
+        const auto duration = duration_cast<nanoseconds>(steady_clock::now() - start_time);
+        std::cout << mark << ": "s << static_cast<double>(duration.count()) / (20 * queries.size())
+                  << " ns per query token"s << std::endl;
+        return results;
+    };
+    const auto expected = run("FindTopDocuments"s);
+    search_server.FreezeVocabulary();
+    const auto frozen = run("FindTopDocuments, frozen vocabulary"s);
+    std::cout << "Results "s << (AreSameResults(expected, frozen) ? "match"s : "DIFFER"s) << std::endl;
+}
+
+void BenchmarkPagination(std::mt19937& generator) {
+    using namespace std::chrono;
+    static constexpr size_t PAGE_SIZE = 20;
+    static constexpr size_t PAGE_COUNT = 50;
+
+    const auto dictionary = GenerateDictionary(generator, 1'000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 50'000, 30);
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {static_cast<int>(i % 10)});
+    }
+    const auto queries = GenerateZipfQueries(generator, dictionary, 20, 3);
+
+    // The first PAGE_COUNT pages of every query, reached by offsets or by cursors
+    const auto run = [&](std::string_view mark, bool use_cursors) {
+        std::vector<std::vector<Document>> results;
+        const auto start_time = steady_clock::now();
+        for (const std::string& query : queries) {
+            std::vector<Document> query_results;
+            PageRequest page_request{0, PAGE_SIZE, ""s};
+            for (size_t page = 0; page < PAGE_COUNT; ++page) {
+                SearchPage search_page = search_server.FindTopDocuments(query, page_request);
+                query_results.insert(query_results.end(), search_page.documents.begin(),
+                                     search_page.documents.end());
+                if (search_page.next_cursor.empty()) {
+                    break;
+                }
+                if (use_cursors) {
+                    page_request.cursor = std::move(search_page.next_cursor);
+                } else {
+                    page_request.offset += PAGE_SIZE;
+                }
+            }
+            results.push_back(std::move(query_results));
+        }
+        const auto duration = duration_cast<microseconds>(steady_clock::now() - start_time);
+        std::cout << mark << ": "s << duration.count() / (queries.size() * PAGE_COUNT) << " us per page"s
+                  << std::endl;
+        return results;
+    };
+    const auto by_offsets = run("Pages by offset"s, false);
+    const auto by_cursors = run("Pages by cursor"s, true);
+    std::cout << "Results "s << (AreSameResults(by_offsets, by_cursors) ? "match"s : "DIFFER"s) << std::endl;
+
+    // Taking the first page of a long range does not split the rest of it
+    std::list<int> value_list(1'000'000);
+    std::iota(value_list.begin(), value_list.end(), 0);
+    const auto start_time = steady_clock::now();
+    const auto first_page = *Paginate(value_list, PAGE_SIZE).begin();
+    const auto duration = duration_cast<nanoseconds>(steady_clock::now() - start_time);
+    std::cout << "First page of a 1M element list: "s << duration.count() << " ns, "s << first_page.size()
+              << " elements"s << std::endl;
+}
+
+bool RunBenchmarks(const std::vector<std::string>& names) {
+    const auto always_passes = [](void (*benchmark)(std::mt19937&)) {
+        return [benchmark](std::mt19937& generator) {
+            benchmark(generator);
+            return true;
+        };
+    };
+    const std::vector<std::pair<std::string_view, std::function<bool(std::mt19937&)>>> benchmarks = {
+            {"policies", always_passes(BenchmarkExecutionPolicies)},
+            {"autocomplete", always_passes(BenchmarkAutocomplete)},
+            {"rankings", always_passes(BenchmarkRankings)},
+            {"batch", always_passes(BenchmarkBatchQueries)},
+            {"impact", always_passes(BenchmarkImpactOrderedSearch)},
+            {"reordering", always_passes(BenchmarkDocumentReordering)},
+            {"filtered", always_passes(BenchmarkFilteredSearch)},
+            {"memory", BenchmarkMemoryFootprint},
+            {"ingest", always_passes(BenchmarkIngest)},
+            {"load", [](std::mt19937& generator) {
+                 BenchmarkLoad(generator);
+                 return true;
+             }},
+            {"parse", always_passes(BenchmarkParse)},
+            {"pagination", always_passes(BenchmarkPagination)},
+    };
+    for (const std::string& name : names) {
+        if (std::none_of(benchmarks.begin(), benchmarks.end(), [&name](const auto& benchmark) {
+                return benchmark.first == name;
+            })) {
+            std::cerr << "Unknown benchmark "s << name << std::endl;
+            return false;
+        }
+    }
+
+    std::mt19937 generator;
+    bool is_passed = true;
+    for (const auto& [name, benchmark] : benchmarks) {
+        if (names.empty() || std::find(names.begin(), names.end(), name) != names.end()) {
+            std::cout << "== "s << name << " =="s << std::endl;
+            is_passed = benchmark(generator) && is_passed;
+        }
+    }
+    return is_passed;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+#include "process_queries.h"
+#include "log_duration.h"
+#include "load_generator.h"
+
+std::string GenerateWord(std::mt19937& generator, int max_length);
+
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length);
+
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                          int word_count, double minus_prob = 0);
+
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                         int query_count, int max_word_count);
+
+// Query words drawn with Zipf's law: the i-th dictionary word has weight 1 / (i + 1)
+std::vector<std::string> GenerateZipfQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                             int query_count, int word_count);
+
+// Documents on topic_count topics: each word comes from the document's topic
+// (a random slice of the dictionary) with probability topic_share, else from
+// the whole dictionary
+std::vector<std::string> GenerateTopicDocuments(std::mt19937& generator, const std::vector<std::string>& dictionary,
+                                                int document_count, int word_count, int topic_count,
+                                                double topic_share);
+
+template <typename ExecutionPolicy>
+void Test(std::string_view mark, const SearchServer& search_server, const std::vector<std::string>& queries,
+          ExecutionPolicy&& policy) {
+    LOG_DURATION(mark);
+    double total_relevance = 0;
+    for (const std::string_view query : queries) {
+        for (const auto& document : search_server.FindTopDocuments(policy, query)) {
+            total_relevance += document.relevance;
+        }
+    }
+    std::cout << total_relevance << std::endl;
+}
+
+#define TEST(policy) Test(#policy, search_server, queries, std::execution::policy)
+
+// Server with the first dictionary word as its only stop word and document i
+// added under id i as ACTUAL with ratings {1, 2, 3}
+SearchServer MakeBenchmarkServer(const std::vector<std::string>& dictionary, const std::vector<std::string>& documents);
+
+// TEST(seq) and TEST(par): total relevance and time of 100 long queries
+void BenchmarkExecutionPolicies(std::mt19937& generator);
+
+// Average Autocomplete latency for 1..3 letter prefixes and term dictionary footprint
+void BenchmarkAutocomplete(std::mt19937& generator);
+
+// FindTopDocuments time with TF-IDF, BM25 and rating-boosted BM25 on the same queries
+void BenchmarkRankings(std::mt19937& generator);
+
+// ProcessQueries against ProcessQueriesBatched on a Zipf-distributed query set
+void BenchmarkBatchQueries(std::mt19937& generator);
+
+// Sequential FindTopDocuments with and without impact-ordered postings: time,
+// share of postings read and whether the results match
+void BenchmarkImpactOrderedSearch(std::mt19937& generator);
+
+// Sequential FindTopDocuments over id-keyed postings, over ordinals in id order
+// and after ReorderDocuments(), with the postings gap sizes of both orders
+void BenchmarkDocumentReordering(std::mt19937& generator);
+
+// BANNED-only and rating > 5 searches: lambdas over id-keyed postings against
+// DocumentFilter over ordinals, before and after ReorderDocuments()
+void BenchmarkFilteredSearch(std::mt19937& generator);
+
+// Per-structure footprint of a 50k document server before and after removing
+// half of it, checked against a bytes-per-posting budget, and the cost of
+// GetMemoryStats(); false if the index goes over the budget
+bool BenchmarkMemoryFootprint(std::mt19937& generator);
+
+// AddDocument throughput on 50k documents and the footprint of the inverted
+// and forward indexes it builds
+void BenchmarkIngest(std::mt19937& generator);
+
+// Latency percentiles at 70% of the measured sequential capacity: sequential
+// and parallel FindTopDocuments, ProcessQueries on batches, and sequential
+// searches mixed with AddDocument/RemoveDocument. Queries come from
+// query_log if it is not empty, else they are Zipf-distributed.
+void BenchmarkLoad(std::mt19937& generator, const std::vector<std::string>& query_log = {});
+
+// Stop-word check and term lookup per token with tree containers and with
+// perfect hashes, and FindTopDocuments per query token before and after
+// FreezeVocabulary()
+void BenchmarkParse(std::mt19937& generator);
+
+// The first pages of paged FindTopDocuments reached by offsets and by
+// cursors, and the cost of taking one page from a long list
+void BenchmarkPagination(std::mt19937& generator);
+
+// Runs the named benchmarks, or all of them for an empty list, in a fixed
+// order on one generator; false if a name is unknown or a benchmark fails
+// its own check (BenchmarkMemoryFootprint going over budget)
+bool RunBenchmarks(const std::vector<std::string>& names);
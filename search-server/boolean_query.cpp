@@ -0,0 +1,410 @@
+#include "boolean_query.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+using namespace std::string_literals;
+
+namespace {
+
+struct Lexeme {
+    enum class Kind {
+        WORD,
+        AND,
+        OR,
+        NOT,
+        OPEN,
+        CLOSE,
+    };
+
+    Kind kind;
+    std::string_view text;
+};
+
+std::vector<Lexeme> SplitIntoLexemes(const std::vector<std::string_view>& tokens) {
+    std::vector<Lexeme> lexemes;
+    for (std::string_view token : tokens) {
+        while (!token.empty() && token.front() == '(') {
+            lexemes.push_back({Lexeme::Kind::OPEN, token.substr(0, 1)});
+            token.remove_prefix(1);
+        }
+        size_t close_count = 0;
+        while (!token.empty() && token.back() == ')') {
+            token.remove_suffix(1);
+            ++close_count;
+        }
+        if (token == "AND") {
+            lexemes.push_back({Lexeme::Kind::AND, token});
+        } else if (token == "OR") {
+            lexemes.push_back({Lexeme::Kind::OR, token});
+        } else if (token == "NOT") {
+            lexemes.push_back({Lexeme::Kind::NOT, token});
+        } else if (!token.empty() || close_count == 0) {
+            lexemes.push_back({Lexeme::Kind::WORD, token});
+        }
+        for (size_t i = 0; i < close_count; ++i) {
+            lexemes.push_back({Lexeme::Kind::CLOSE, ")"});
+        }
+    }
+    return lexemes;
+}
+
+QueryNode MakeNode(QueryNode::Type type, std::vector<QueryNode> children) {
+    QueryNode node;
+    node.type = type;
+    node.children = std::move(children);
+    return node;
+}
+
+std::optional<QueryNode> Combine(QueryNode::Type type, std::vector<QueryNode> children) {
+    if (children.empty()) {
+        return std::nullopt;
+    }
+    if (children.size() == 1) {
+        return std::move(children.front());
+    }
+    return MakeNode(type, std::move(children));
+}
+
+class BooleanQueryParser {
+public:
+    BooleanQueryParser(std::vector<Lexeme> lexemes,
+                       const std::function<ResolvedQueryWord(std::string_view)>& resolve_word)
+            : lexemes_(std::move(lexemes))
+            , resolve_word_(resolve_word) {
+    }
+
+    std::optional<QueryNode> Parse() {
+        auto result = ParseGroup(false);
+        if (position_ != lexemes_.size()) {
+            throw std::invalid_argument("Unbalanced parenthesis in query"s);
+        }
+        return result;
+    }
+
+private:
+    std::vector<Lexeme> lexemes_;
+    const std::function<ResolvedQueryWord(std::string_view)>& resolve_word_;
+    size_t position_ = 0;
+
+    bool IsAt(Lexeme::Kind kind) const {
+        return position_ < lexemes_.size() && lexemes_[position_].kind == kind;
+    }
+
+    bool IsAtOperand() const {
+        return position_ < lexemes_.size()
+               && (IsAt(Lexeme::Kind::WORD) || IsAt(Lexeme::Kind::NOT) || IsAt(Lexeme::Kind::OPEN));
+    }
+
+    bool IsAtMinusWord() const {
+        return IsAt(Lexeme::Kind::WORD) && !lexemes_[position_].text.empty()
+               && lexemes_[position_].text.front() == '-';
+    }
+
+    // Minus words exclude their documents from the whole enclosing group,
+    // wherever they stand in it, so they never split an AND or OR
+    void TakeMinusWords(std::vector<QueryNode>& exclusions) {
+        while (IsAtMinusWord()) {
+            auto resolved = resolve_word_(lexemes_[position_++].text);
+            if (resolved.node) {
+                exclusions.push_back(std::move(*resolved.node));
+            }
+        }
+    }
+
+    void ExpectOperand(std::string_view after) const {
+        if (!IsAtOperand()) {
+            throw std::invalid_argument("Missing operand after "s + std::string(after));
+        }
+    }
+
+    // Sequence of alternatives up to ')' or the end. A nested group of minus
+    // words only means NOT; at the top level it matches nothing, as in plain queries
+    std::optional<QueryNode> ParseGroup(bool is_nested) {
+        std::vector<QueryNode> alternatives;
+        std::vector<QueryNode> exclusions;
+        while (IsAtOperand()) {
+            if (IsAtMinusWord()) {
+                TakeMinusWords(exclusions);
+                if (IsAt(Lexeme::Kind::OR) && !alternatives.empty()) {
+                    ++position_;
+                    ExpectOperand("OR"s);
+                }
+                continue;
+            }
+            if (auto node = ParseAnd(exclusions)) {
+                alternatives.push_back(std::move(*node));
+            }
+            if (IsAt(Lexeme::Kind::OR)) {
+                ++position_;
+                ExpectOperand("OR"s);
+            }
+        }
+        if (IsAt(Lexeme::Kind::AND) || IsAt(Lexeme::Kind::OR)) {
+            throw std::invalid_argument("Missing operand before "s + std::string(lexemes_[position_].text));
+        }
+        auto result = Combine(QueryNode::Type::OR, std::move(alternatives));
+        if (!result && is_nested && !exclusions.empty()) {
+            return MakeNode(QueryNode::Type::NOT, {*Combine(QueryNode::Type::OR, std::move(exclusions))});
+        }
+        if (result && !exclusions.empty()) {
+            std::vector<QueryNode> children;
+            children.push_back(std::move(*result));
+            children.push_back(MakeNode(QueryNode::Type::NOT, {*Combine(QueryNode::Type::OR, std::move(exclusions))}));
+            result = MakeNode(QueryNode::Type::AND, std::move(children));
+        }
+        return result;
+    }
+
+    // Minus words between the operands go to the exclusions of the group
+    std::optional<QueryNode> ParseAnd(std::vector<QueryNode>& exclusions) {
+        std::vector<QueryNode> operands;
+        if (auto node = ParseUnary()) {
+            operands.push_back(std::move(*node));
+        }
+        TakeMinusWords(exclusions);
+        while (IsAt(Lexeme::Kind::AND)) {
+            ++position_;
+            ExpectOperand("AND"s);
+            if (auto node = ParseUnary()) {
+                operands.push_back(std::move(*node));
+            }
+            TakeMinusWords(exclusions);
+        }
+        return Combine(QueryNode::Type::AND, std::move(operands));
+    }
+
+    std::optional<QueryNode> ParseUnary() {
+        const Lexeme& lexeme = lexemes_[position_++];
+        switch (lexeme.kind) {
+            case Lexeme::Kind::NOT: {
+                ExpectOperand("NOT"s);
+                auto operand = ParseUnary();
+                if (!operand) {
+                    return std::nullopt;
+                }
+                return MakeNode(QueryNode::Type::NOT, {std::move(*operand)});
+            }
+            case Lexeme::Kind::OPEN: {
+                auto group = ParseGroup(true);
+                if (!IsAt(Lexeme::Kind::CLOSE)) {
+                    throw std::invalid_argument("Unbalanced parenthesis in query"s);
+                }
+                ++position_;
+                return group;
+            }
+            case Lexeme::Kind::WORD: {
+                auto resolved = resolve_word_(lexeme.text);
+                if (resolved.is_minus && resolved.node) {
+                    return MakeNode(QueryNode::Type::NOT, {std::move(*resolved.node)});
+                }
+                return std::move(resolved.node);
+            }
+            default:
+                throw std::invalid_argument("Unexpected "s + std::string(lexeme.text) + " in query"s);
+        }
+    }
+};
+
+void CollectPositiveTerms(const QueryNode& node, bool is_negated, std::vector<std::string_view>& terms) {
+    switch (node.type) {
+        case QueryNode::Type::TERM:
+            if (!is_negated) {
+                terms.push_back(node.term);
+            }
+            break;
+        case QueryNode::Type::NOT:
+            CollectPositiveTerms(node.children.front(), !is_negated, terms);
+            break;
+        default:
+            for (const QueryNode& child : node.children) {
+                CollectPositiveTerms(child, is_negated, terms);
+            }
+    }
+}
+
+}  // namespace
+
+bool HasBooleanOperators(const std::vector<std::string_view>& tokens) {
+    return std::any_of(tokens.begin(), tokens.end(), [](std::string_view token) {
+        return token == "AND" || token == "OR" || token == "NOT"
+               || (!token.empty() && (token.front() == '(' || token.back() == ')'));
+    });
+}
+
+std::optional<QueryNode> ParseBooleanQuery(const std::vector<std::string_view>& tokens,
+                                           const std::function<ResolvedQueryWord(std::string_view)>& resolve_word) {
+    return BooleanQueryParser(SplitIntoLexemes(tokens), resolve_word).Parse();
+}
+
+std::vector<std::string_view> CollectPositiveTerms(const QueryNode& node) {
+    std::vector<std::string_view> terms;
+    CollectPositiveTerms(node, false, terms);
+    return terms;
+}
+
+SortedIdCursor::SortedIdCursor(const std::vector<int>& ids)
+        : ids_(ids) {
+}
+
+bool SortedIdCursor::Contains(int id) {
+    if (position_ >= ids_.size() || ids_[position_] >= id) {
+        return position_ < ids_.size() && ids_[position_] == id;
+    }
+    // Gallop: double the step until we pass id, then binary search the last step
+    size_t step = 1;
+    size_t low = position_;
+    while (low + step < ids_.size() && ids_[low + step] < id) {
+        low += step;
+        step *= 2;
+    }
+    const size_t high = std::min(low + step, ids_.size());
+    position_ = std::lower_bound(ids_.begin() + low, ids_.begin() + high, id) - ids_.begin();
+    return position_ < ids_.size() && ids_[position_] == id;
+}
+
+BooleanQueryEvaluator::BooleanQueryEvaluator(PostingsLookup find_postings, const CountedSet<int>& all_document_ids)
+        : find_postings_(std::move(find_postings))
+        , all_document_ids_(all_document_ids) {
+}
+
+std::vector<int> BooleanQueryEvaluator::Evaluate(const QueryNode& node) const {
+    switch (node.type) {
+        case QueryNode::Type::TERM:
+            return EvaluateTerm(node);
+        case QueryNode::Type::AND:
+            return EvaluateAnd(node);
+        case QueryNode::Type::OR:
+            return EvaluateOr(node);
+        case QueryNode::Type::NOT:
+            return EvaluateNot(node);
+    }
+    return {};
+}
+
+bool BooleanQueryEvaluator::Matches(const QueryNode& node, int document_id) const {
+    switch (node.type) {
+        case QueryNode::Type::TERM: {
+            const Postings* postings = find_postings_(node.term);
+            return postings != nullptr && postings->count(document_id) > 0;
+        }
+        case QueryNode::Type::AND:
+            return std::all_of(node.children.begin(), node.children.end(),
+                               [&](const QueryNode& child) { return Matches(child, document_id); });
+        case QueryNode::Type::OR:
+            return std::any_of(node.children.begin(), node.children.end(),
+                               [&](const QueryNode& child) { return Matches(child, document_id); });
+        case QueryNode::Type::NOT:
+            return !Matches(node.children.front(), document_id);
+    }
+    return false;
+}
+
+std::vector<int> BooleanQueryEvaluator::EvaluateAnd(const QueryNode& node) const {
+    std::vector<const QueryNode*> positives;
+    std::vector<const QueryNode*> negatives;
+    for (const QueryNode& child : node.children) {
+        if (child.type == QueryNode::Type::NOT) {
+            negatives.push_back(&child.children.front());
+        } else {
+            positives.push_back(&child);
+        }
+    }
+    std::sort(positives.begin(), positives.end(),
+              [this](const QueryNode* lhs, const QueryNode* rhs) {
+                  return EstimateSize(*lhs) < EstimateSize(*rhs);
+              });
+
+    std::vector<int> result;
+    if (positives.empty()) {
+        result.assign(all_document_ids_.begin(), all_document_ids_.end());
+    } else {
+        result = Evaluate(*positives.front());
+    }
+    for (size_t i = 1; i < positives.size() && !result.empty(); ++i) {
+        Filter(result, *positives[i], false);
+    }
+    for (size_t i = 0; i < negatives.size() && !result.empty(); ++i) {
+        Filter(result, *negatives[i], true);
+    }
+    return result;
+}
+
+std::vector<int> BooleanQueryEvaluator::EvaluateOr(const QueryNode& node) const {
+    std::vector<int> result;
+    for (const QueryNode& child : node.children) {
+        const std::vector<int> child_ids = Evaluate(child);
+        std::vector<int> merged;
+        merged.reserve(result.size() + child_ids.size());
+        std::set_union(result.begin(), result.end(), child_ids.begin(), child_ids.end(),
+                       std::back_inserter(merged));
+        result = std::move(merged);
+    }
+    return result;
+}
+
+std::vector<int> BooleanQueryEvaluator::EvaluateNot(const QueryNode& node) const {
+    std::vector<int> result(all_document_ids_.begin(), all_document_ids_.end());
+    Filter(result, node.children.front(), true);
+    return result;
+}
+
+std::vector<int> BooleanQueryEvaluator::EvaluateTerm(const QueryNode& node) const {
+    std::vector<int> result;
+    if (const Postings* postings = find_postings_(node.term)) {
+        result.reserve(postings->size());
+        for (const auto& [document_id, _] : *postings) {
+            result.push_back(document_id);
+        }
+    }
+    return result;
+}
+
+void BooleanQueryEvaluator::Filter(std::vector<int>& ids, const QueryNode& node, bool is_negated) const {
+    if (node.type == QueryNode::Type::TERM) {
+        // A term is probed in its postings tree, never copied out
+        const Postings* postings = find_postings_(node.term);
+        ids.erase(std::remove_if(ids.begin(), ids.end(),
+                                 [&](int id) {
+                                     const bool contains = postings != nullptr && postings->count(id) > 0;
+                                     return contains == is_negated;
+                                 }),
+                  ids.end());
+        return;
+    }
+    const std::vector<int> node_ids = Evaluate(node);
+    SortedIdCursor cursor(node_ids);
+    ids.erase(std::remove_if(ids.begin(), ids.end(),
+                             [&](int id) { return cursor.Contains(id) == is_negated; }),
+              ids.end());
+}
+
+size_t BooleanQueryEvaluator::EstimateSize(const QueryNode& node) const {
+    switch (node.type) {
+        case QueryNode::Type::TERM: {
+            const Postings* postings = find_postings_(node.term);
+            return postings == nullptr ? 0 : postings->size();
+        }
+        case QueryNode::Type::AND: {
+            size_t result = all_document_ids_.size();
+            for (const QueryNode& child : node.children) {
+                if (child.type != QueryNode::Type::NOT) {
+                    result = std::min(result, EstimateSize(child));
+                }
+            }
+            return result;
+        }
+        case QueryNode::Type::OR: {
+            size_t result = 0;
+            for (const QueryNode& child : node.children) {
+                result += EstimateSize(child);
+            }
+            return std::min(result, all_document_ids_.size());
+        }
+        case QueryNode::Type::NOT:
+            return all_document_ids_.size();
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <string_view>
+#include <vector>
+
+#include "memory_stats.h"
+
+struct QueryNode {
+    enum class Type {
+        TERM,
+        AND,
+        OR,
+        NOT,
+    };
+
+    Type type = Type::TERM;
+    std::string_view term;            // TERM only
+    std::vector<QueryNode> children;  // AND and OR: any number, NOT: exactly one
+};
+
+struct ResolvedQueryWord {
+    std::optional<QueryNode> node;  // empty for stop words
+    bool is_minus = false;
+};
+
+// True if tokens use AND, OR, NOT or parentheses
+bool HasBooleanOperators(const std::vector<std::string_view>& tokens);
+
+// Grammar, from the lowest precedence: juxtaposition or OR, then AND, then NOT.
+// Parentheses group. As in plain queries, a minus word anywhere among the terms
+// of a group excludes its documents from the whole group: "a b -c" is
+// (a OR b) AND NOT c, and "a -c AND b" is (a AND b) AND NOT c.
+// resolve_word validates a word (with its '-') and turns it into a node.
+std::optional<QueryNode> ParseBooleanQuery(const std::vector<std::string_view>& tokens,
+                                           const std::function<ResolvedQueryWord(std::string_view)>& resolve_word);
+
+// Terms which make a document match, i.e. not under a NOT
+std::vector<std::string_view> CollectPositiveTerms(const QueryNode& node);
+
+// Forward-only membership test over a sorted id list: ids must be asked in
+// ascending order, the cursor gallops over the skipped part of the list
+class SortedIdCursor {
+public:
+    explicit SortedIdCursor(const std::vector<int>& ids);
+
+    bool Contains(int id);
+
+private:
+    const std::vector<int>& ids_;
+    size_t position_ = 0;
+};
+
+// Evaluates a query tree over id-sorted postings. Intersections are driven by
+// the smallest operand: other terms are probed with std::map lookups, other
+// subtrees with galloping search, and NOT operands are subtracted the same way
+// instead of being materialized.
+class BooleanQueryEvaluator {
+public:
+    using Postings = CountedMap<int, double>;
+    using PostingsLookup = std::function<const Postings*(std::string_view)>;
+
+    BooleanQueryEvaluator(PostingsLookup find_postings, const CountedSet<int>& all_document_ids);
+
+    // Sorted ids of matching documents
+    std::vector<int> Evaluate(const QueryNode& node) const;
+
+    bool Matches(const QueryNode& node, int document_id) const;
+
+private:
+    PostingsLookup find_postings_;
+    const CountedSet<int>& all_document_ids_;
+
+    std::vector<int> EvaluateAnd(const QueryNode& node) const;
+    std::vector<int> EvaluateOr(const QueryNode& node) const;
+    std::vector<int> EvaluateNot(const QueryNode& node) const;
+    std::vector<int> EvaluateTerm(const QueryNode& node) const;
+    // Keeps ids of documents that (do not, if is_negated) match node
+    void Filter(std::vector<int>& ids, const QueryNode& node, bool is_negated) const;
+    size_t EstimateSize(const QueryNode& node) const;
+};
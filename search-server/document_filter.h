@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "document.h"
+
+// Declarative document predicate. Layouts that keep per-block summaries of
+// status and rating skip blocks the filter can't accept; elsewhere the filter
+// is called like any other predicate.
+struct DocumentFilter {
+    uint32_t status_mask = ~0u;  // bit i set: documents with status i pass
+    int min_rating = std::numeric_limits<int>::min();
+    int max_rating = std::numeric_limits<int>::max();
+
+    static uint32_t GetStatusBit(DocumentStatus status) {
+        return 1u << static_cast<int>(status);
+    }
+
+    static DocumentFilter ForStatus(DocumentStatus status) {
+        DocumentFilter filter;
+        filter.status_mask = GetStatusBit(status);
+        return filter;
+    }
+
+    bool operator()(int /*document_id*/, DocumentStatus status, int rating) const {
+        return (status_mask & GetStatusBit(status)) != 0 && min_rating <= rating && rating <= max_rating;
+    }
+
+    // False if no document with a status from block_status_mask and a rating
+    // within [block_min_rating, block_max_rating] can pass
+    bool MayAccept(uint32_t block_status_mask, int block_min_rating, int block_max_rating) const {
+        return (status_mask & block_status_mask) != 0 && min_rating <= block_max_rating
+               && block_min_rating <= max_rating;
+    }
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "memory_stats.h"
+
+// A distinct word of a document, stored as its place in the document text
+struct ForwardEntry {
+    uint32_t offset;
+    uint32_t length;
+    double term_freq;
+};
+
+// Distinct words of a document sorted by word: one flat array per document
+// instead of a tree node per word
+using ForwardList = std::vector<ForwardEntry, CountingAllocator<ForwardEntry>>;
+
+// Read-only (word, term frequency) range over a ForwardList, valid while its
+// document stays in the server. Iterating yields pairs by value.
+class WordFrequenciesView {
+public:
+    // Pairs are made on dereference, so by the C++17 rules this is an input
+    // iterator; it still has the arithmetic and ordering of a pointer
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<std::string_view, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator() = default;
+
+        Iterator(std::string_view text, const ForwardEntry* entry)
+                : text_(text)
+                , entry_(entry) {
+        }
+
+        value_type operator*() const {
+            return {text_.substr(entry_->offset, entry_->length), entry_->term_freq};
+        }
+
+        value_type operator[](difference_type offset) const {
+            return *(*this + offset);
+        }
+
+        Iterator& operator++() {
+            ++entry_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++entry_;
+            return previous;
+        }
+
+        Iterator& operator--() {
+            --entry_;
+            return *this;
+        }
+
+        Iterator operator--(int) {
+            Iterator previous = *this;
+            --entry_;
+            return previous;
+        }
+
+        Iterator& operator+=(difference_type offset) {
+            entry_ += offset;
+            return *this;
+        }
+
+        Iterator& operator-=(difference_type offset) {
+            entry_ -= offset;
+            return *this;
+        }
+
+        friend Iterator operator+(Iterator it, difference_type offset) {
+            return it += offset;
+        }
+
+        friend Iterator operator+(difference_type offset, Iterator it) {
+            return it += offset;
+        }
+
+        friend Iterator operator-(Iterator it, difference_type offset) {
+            return it -= offset;
+        }
+
+        friend difference_type operator-(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.entry_ - rhs.entry_;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.entry_ == rhs.entry_;
+        }
+
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.entry_ != rhs.entry_;
+        }
+
+        friend bool operator<(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.entry_ < rhs.entry_;
+        }
+
+        friend bool operator>(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.entry_ > rhs.entry_;
+        }
+
+        friend bool operator<=(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.entry_ <= rhs.entry_;
+        }
+
+        friend bool operator>=(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.entry_ >= rhs.entry_;
+        }
+
+    private:
+        std::string_view text_;
+        const ForwardEntry* entry_ = nullptr;
+    };
+
+    WordFrequenciesView() = default;
+
+    WordFrequenciesView(std::string_view text, const ForwardList& entries)
+            : text_(text)
+            , entries_(entries.data())
+            , size_(entries.size()) {
+    }
+
+    Iterator begin() const {
+        return {text_, entries_};
+    }
+
+    Iterator end() const {
+        return {text_, entries_ + size_};
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    // 0 if the document doesn't have the word
+    double GetTermFreq(std::string_view word) const {
+        const ForwardEntry* const entries_end = entries_ + size_;
+        const ForwardEntry* const entry = std::lower_bound(
+                entries_, entries_end, word, [this](const ForwardEntry& entry, std::string_view value) {
+                    return GetWord(entry) < value;
+                });
+        return entry != entries_end && GetWord(*entry) == word ? entry->term_freq : 0.0;
+    }
+
+private:
+    std::string_view text_;
+    const ForwardEntry* entries_ = nullptr;
+    size_t size_ = 0;
+
+    std::string_view GetWord(const ForwardEntry& entry) const {
+        return text_.substr(entry.offset, entry.length);
+    }
+};
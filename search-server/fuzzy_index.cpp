@@ -0,0 +1,96 @@
+#include "fuzzy_index.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_set>
+
+FuzzyIndex::FuzzyIndex(int max_edit_distance)
+        : max_edit_distance_(max_edit_distance) {
+}
+
+void FuzzyIndex::AddTerm(std::string_view term) {
+    for (std::string& deleted : GenerateDeletes(term)) {
+        auto& terms = deletes_[std::move(deleted)];
+        if (std::find(terms.begin(), terms.end(), term) == terms.end()) {
+            terms.push_back(term);
+        }
+    }
+}
+
+std::vector<std::pair<std::string_view, int>> FuzzyIndex::FindCandidates(std::string_view word) const {
+    std::vector<std::pair<std::string_view, int>> result;
+    std::unordered_set<std::string_view> checked;
+    for (const std::string& deleted : GenerateDeletes(word)) {
+        const auto it = deletes_.find(deleted);
+        if (it == deletes_.end()) {
+            continue;
+        }
+        for (const std::string_view term : it->second) {
+            if (!checked.insert(term).second) {
+                continue;
+            }
+            const int distance = ComputeEditDistance(word, term, max_edit_distance_);
+            if (distance <= max_edit_distance_) {
+                result.push_back({term, distance});
+            }
+        }
+    }
+    return result;
+}
+
+size_t FuzzyIndex::GetDeleteCount() const {
+    return deletes_.size();
+}
+
+int FuzzyIndex::ComputeEditDistance(std::string_view lhs, std::string_view rhs, int max_distance) {
+    const int lhs_size = static_cast<int>(lhs.size());
+    const int rhs_size = static_cast<int>(rhs.size());
+    if (std::abs(lhs_size - rhs_size) > max_distance) {
+        return max_distance + 1;
+    }
+    // Three rolling rows are enough for transpositions
+    std::vector<int> before_previous(rhs_size + 1);
+    std::vector<int> previous(rhs_size + 1);
+    std::vector<int> current(rhs_size + 1);
+    for (int j = 0; j <= rhs_size; ++j) {
+        previous[j] = j;
+    }
+    for (int i = 1; i <= lhs_size; ++i) {
+        current[0] = i;
+        int row_min = current[0];
+        for (int j = 1; j <= rhs_size; ++j) {
+            const int cost = lhs[i - 1] == rhs[j - 1] ? 0 : 1;
+            current[j] = std::min({previous[j] + 1, current[j - 1] + 1, previous[j - 1] + cost});
+            if (i > 1 && j > 1 && lhs[i - 1] == rhs[j - 2] && lhs[i - 2] == rhs[j - 1]) {
+                current[j] = std::min(current[j], before_previous[j - 2] + 1);
+            }
+            row_min = std::min(row_min, current[j]);
+        }
+        if (row_min > max_distance) {
+            return max_distance + 1;
+        }
+        std::swap(before_previous, previous);
+        std::swap(previous, current);
+    }
+    return std::min(previous[rhs_size], max_distance + 1);
+}
+
+std::vector<std::string> FuzzyIndex::GenerateDeletes(std::string_view word) const {
+    std::unordered_set<std::string> seen{std::string(word)};
+    std::vector<std::string> result{std::string(word)};
+    size_t level_begin = 0;
+    for (int distance = 0; distance < max_edit_distance_; ++distance) {
+        const size_t level_end = result.size();
+        for (size_t i = level_begin; i < level_end; ++i) {
+            for (size_t position = 0; position < result[i].size(); ++position) {
+                std::string deleted = result[i];
+                deleted.erase(position, 1);
+                if (seen.insert(deleted).second) {
+                    result.push_back(std::move(deleted));
+                }
+            }
+        }
+        level_begin = level_end;
+    }
+    return result;
+}
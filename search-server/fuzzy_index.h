@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct FuzzySearchOptions {
+    int max_edit_distance = 2;
+    // Relevance of a corrected word is multiplied by this value once per edit
+    double edit_penalty = 0.5;
+};
+
+// Symmetric delete index: every term is stored under all strings obtained by
+// deleting up to max_edit_distance characters from it. Candidates for a query
+// word are the terms sharing one of its deletes, verified with the real
+// edit distance, so a lookup never scans the vocabulary.
+class FuzzyIndex {
+public:
+    explicit FuzzyIndex(int max_edit_distance);
+
+    // term must outlive the index
+    void AddTerm(std::string_view term);
+
+    // Indexed terms within max_edit_distance of word, with their edit distances
+    std::vector<std::pair<std::string_view, int>> FindCandidates(std::string_view word) const;
+
+    size_t GetDeleteCount() const;
+
+    // Optimal string alignment distance (Levenshtein with adjacent transpositions),
+    // or max_distance + 1 when it exceeds max_distance
+    static int ComputeEditDistance(std::string_view lhs, std::string_view rhs, int max_distance);
+
+private:
+    int max_edit_distance_;
+    std::unordered_map<std::string, std::vector<std::string_view>> deletes_;
+
+    std::vector<std::string> GenerateDeletes(std::string_view word) const;
+};
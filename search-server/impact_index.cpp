@@ -0,0 +1,37 @@
+#include "impact_index.h"
+
+#include <algorithm>
+
+void ImpactOrderedIndex::Build(const CountedMap<std::string_view, CountedMap<int, double>>& word_to_document_freqs) {
+    for (const auto& [word, postings] : word_to_document_freqs) {
+        if (word_to_impacts_.count(word) == 0) {
+            word_to_impacts_.emplace(word, MakeImpactList(postings));
+        }
+    }
+}
+
+void ImpactOrderedIndex::Invalidate(std::string_view word) {
+    word_to_impacts_.erase(word);
+}
+
+const ImpactList* ImpactOrderedIndex::Find(std::string_view word) const {
+    const auto it = word_to_impacts_.find(word);
+    return it == word_to_impacts_.end() ? nullptr : &it->second;
+}
+
+ImpactList ImpactOrderedIndex::MakeImpactList(const CountedMap<int, double>& postings) {
+    ImpactList result;
+    result.postings.reserve(postings.size());
+    for (const auto [document_id, term_freq] : postings) {
+        result.postings.push_back({document_id, term_freq});
+    }
+    std::stable_sort(result.postings.begin(), result.postings.end(),
+                     [](const ImpactPosting& lhs, const ImpactPosting& rhs) {
+                         return lhs.term_freq > rhs.term_freq;
+                     });
+    // Lists are sorted, so a block maximum is its first entry
+    for (size_t begin = 0; begin < result.postings.size(); begin += IMPACT_BLOCK_SIZE) {
+        result.block_max_term_freqs.push_back(result.postings[begin].term_freq);
+    }
+    return result;
+}
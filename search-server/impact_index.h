@@ -0,0 +1,44 @@
+#pragma once
+
+#include <map>
+#include <string_view>
+#include <vector>
+
+#include "memory_stats.h"
+
+struct ImpactPosting {
+    int document_id;
+    double term_freq;
+};
+
+// Postings of a word ordered by descending term frequency (ties by id), split
+// into blocks of IMPACT_BLOCK_SIZE with the largest term frequency of each block
+struct ImpactList {
+    std::vector<ImpactPosting> postings;
+    std::vector<double> block_max_term_freqs;
+};
+
+struct ImpactSearchStats {
+    size_t postings_total = 0;    // postings of the query words
+    size_t postings_touched = 0;  // postings read before the top was settled
+};
+
+const size_t IMPACT_BLOCK_SIZE = 64;
+
+// Impact-ordered copies of the postings lists. A list is dropped when a
+// document with its word is added or removed and built again by Build().
+class ImpactOrderedIndex {
+public:
+    // Builds lists missing for the words of word_to_document_freqs
+    void Build(const CountedMap<std::string_view, CountedMap<int, double>>& word_to_document_freqs);
+
+    void Invalidate(std::string_view word);
+
+    // nullptr if the word's list is out of date
+    const ImpactList* Find(std::string_view word) const;
+
+private:
+    std::map<std::string_view, ImpactList> word_to_impacts_;
+
+    static ImpactList MakeImpactList(const CountedMap<int, double>& postings);
+};
@@ -0,0 +1,119 @@
+#include "load_generator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <thread>
+
+using namespace std::string_literals;
+
+namespace {
+
+std::chrono::nanoseconds GetPercentile(const std::vector<std::chrono::nanoseconds>& sorted_latencies,
+                                       double percentile) {
+    if (sorted_latencies.empty()) {
+        return {};
+    }
+    const auto rank = static_cast<size_t>(std::ceil(percentile * sorted_latencies.size()));
+    return sorted_latencies[std::clamp<size_t>(rank, 1, sorted_latencies.size()) - 1];
+}
+
+LatencyPercentiles ComputePercentiles(std::vector<std::chrono::nanoseconds> latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    LatencyPercentiles percentiles;
+    percentiles.count = latencies.size();
+    percentiles.p50 = GetPercentile(latencies, 0.5);
+    percentiles.p99 = GetPercentile(latencies, 0.99);
+    percentiles.p999 = GetPercentile(latencies, 0.999);
+    percentiles.max = latencies.empty() ? std::chrono::nanoseconds{} : latencies.back();
+    return percentiles;
+}
+
+}  // namespace
+
+LoadReport RunLoad(const LoadOptions& options, const LoadOperation& read, const LoadOperation& write) {
+    using namespace std::chrono;
+
+    std::vector<nanoseconds> latencies(options.request_count);
+    std::atomic<size_t> next_request{0};
+    std::shared_mutex server_mutex;
+    const bool has_writes = options.write_interval > 0 && write;
+    const auto is_write = [&options, has_writes](size_t request_index) {
+        return has_writes && request_index % options.write_interval == options.write_interval - 1;
+    };
+    const double interval_ns = 1e9 / options.target_qps;
+    const auto start_time = steady_clock::now();
+
+    const auto run_client = [&]() {
+        while (true) {
+            const size_t request_index = next_request.fetch_add(1, std::memory_order_relaxed);
+            if (request_index >= options.request_count) {
+                return;
+            }
+            const auto due_time = start_time + nanoseconds(static_cast<int64_t>(request_index * interval_ns));
+            std::this_thread::sleep_until(due_time);
+            if (is_write(request_index)) {
+                std::unique_lock lock(server_mutex);
+                write(request_index);
+            } else if (has_writes) {
+                std::shared_lock lock(server_mutex);
+                read(request_index);
+            } else {
+                read(request_index);
+            }
+            latencies[request_index] = duration_cast<nanoseconds>(steady_clock::now() - due_time);
+        }
+    };
+    std::vector<std::thread> clients;
+    for (int i = 0; i < options.client_count; ++i) {
+        clients.emplace_back(run_client);
+    }
+    for (std::thread& client : clients) {
+        client.join();
+    }
+    const auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start_time);
+
+    std::vector<nanoseconds> read_latencies;
+    std::vector<nanoseconds> write_latencies;
+    for (size_t i = 0; i < latencies.size(); ++i) {
+        (is_write(i) ? write_latencies : read_latencies).push_back(latencies[i]);
+    }
+    LoadReport report;
+    report.request_count = options.request_count;
+    report.throughput = elapsed.count() > 0.0 ? options.request_count / elapsed.count() : 0.0;
+    report.reads = ComputePercentiles(std::move(read_latencies));
+    report.writes = ComputePercentiles(std::move(write_latencies));
+    return report;
+}
+
+std::vector<std::string> ReadQueryLog(std::istream& input) {
+    std::vector<std::string> queries;
+    std::string line;
+    while (std::getline(input, line)) {
+        if (!line.empty()) {
+            queries.push_back(std::move(line));
+        }
+    }
+    return queries;
+}
+
+std::ostream& operator<<(std::ostream& output, const LatencyPercentiles& percentiles) {
+    using namespace std::chrono;
+    const auto to_us = [](nanoseconds latency) {
+        return duration_cast<microseconds>(latency).count();
+    };
+    return output << "p50 "s << to_us(percentiles.p50) << " us, p99 "s << to_us(percentiles.p99) << " us, p999 "s
+                  << to_us(percentiles.p999) << " us, max "s << to_us(percentiles.max) << " us"s;
+}
+
+std::ostream& operator<<(std::ostream& output, const LoadReport& report) {
+    output << report.request_count << " requests, "s << report.throughput << " per second, "s;
+    if (report.writes.count == 0) {
+        return output << report.reads;
+    }
+    return output << report.reads.count << " reads: "s << report.reads << "; "s
+                  << report.writes.count << " writes: "s << report.writes;
+}
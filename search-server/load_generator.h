@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+// Runs request number request_index
+using LoadOperation = std::function<void(size_t request_index)>;
+
+struct LoadOptions {
+    double target_qps = 1'000.0;  // arrival rate of requests
+    int client_count = 4;
+    size_t request_count = 10'000;
+    size_t write_interval = 0;    // every write_interval-th request is a write, 0 for none
+};
+
+struct LatencyPercentiles {
+    size_t count = 0;
+    std::chrono::nanoseconds p50{};
+    std::chrono::nanoseconds p99{};
+    std::chrono::nanoseconds p999{};
+    std::chrono::nanoseconds max{};
+};
+
+struct LoadReport {
+    size_t request_count = 0;
+    double throughput = 0.0;  // completed requests per second
+    LatencyPercentiles reads;
+    LatencyPercentiles writes;  // empty without writes
+};
+
+// Sends options.request_count requests at options.target_qps from
+// options.client_count threads. A client takes the next request, waits until
+// it is due and runs it. Latency is measured from the due time, not from the
+// moment the client got to it, so a stall is charged to every request that
+// was due meanwhile (coordinated omission correction). Reads share a lock
+// that writes take exclusively, so write may modify what read uses. Read and
+// write latencies are reported separately.
+LoadReport RunLoad(const LoadOptions& options, const LoadOperation& read, const LoadOperation& write = {});
+
+// One query per non-empty line
+std::vector<std::string> ReadQueryLog(std::istream& input);
+
+std::ostream& operator<<(std::ostream& output, const LatencyPercentiles& percentiles);
+std::ostream& operator<<(std::ostream& output, const LoadReport& report);
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <new>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+// Heap usage of one structure. Counters are atomic, so they can be read
+// from a monitoring thread while the owner allocates.
+struct AllocationCounter {
+    std::atomic<size_t> bytes{0};           // bytes asked for
+    std::atomic<size_t> overhead_bytes{0};  // malloc rounding and chunk headers on top
+    std::atomic<size_t> allocation_count{0};
+};
+
+struct StructureMemory {
+    size_t bytes = 0;
+    size_t overhead_bytes = 0;
+    size_t allocation_count = 0;
+
+    size_t GetTotalBytes() const {
+        return bytes + overhead_bytes;
+    }
+};
+
+// Main structures of a SearchServer; optional indexes are not included
+struct MemoryStats {
+    StructureMemory document_texts;  // stored document texts
+    StructureMemory inverted_index;  // word -> document -> term frequency
+    StructureMemory forward_index;   // sorted word arrays per document
+    StructureMemory document_data;   // rating, status and length per document
+    StructureMemory document_ids;
+    size_t term_count = 0;
+    size_t posting_count = 0;
+    double average_posting_length = 0.0;
+
+    size_t GetTotalBytes() const {
+        return document_texts.GetTotalBytes() + inverted_index.GetTotalBytes() + forward_index.GetTotalBytes()
+               + document_data.GetTotalBytes() + document_ids.GetTotalBytes();
+    }
+};
+
+// Allocator reporting to an AllocationCounter. A default-constructed one
+// counts nothing, so containers built without a counter behave as usual.
+template <typename T>
+class CountingAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    CountingAllocator() noexcept = default;
+
+    explicit CountingAllocator(AllocationCounter* counter) noexcept
+            : counter_(counter) {
+    }
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) noexcept
+            : counter_(other.GetCounter()) {
+    }
+
+    T* allocate(size_t count) {
+        const size_t bytes = count * sizeof(T);
+        T* data = static_cast<T*>(::operator new(bytes));
+        if (counter_ != nullptr) {
+            counter_->bytes.fetch_add(bytes, std::memory_order_relaxed);
+            counter_->overhead_bytes.fetch_add(ComputeOverhead(data, bytes), std::memory_order_relaxed);
+            counter_->allocation_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        return data;
+    }
+
+    void deallocate(T* data, size_t count) noexcept {
+        const size_t bytes = count * sizeof(T);
+        if (counter_ != nullptr) {
+            counter_->bytes.fetch_sub(bytes, std::memory_order_relaxed);
+            counter_->overhead_bytes.fetch_sub(ComputeOverhead(data, bytes), std::memory_order_relaxed);
+            counter_->allocation_count.fetch_sub(1, std::memory_order_relaxed);
+        }
+        ::operator delete(data);
+    }
+
+    AllocationCounter* GetCounter() const noexcept {
+        return counter_;
+    }
+
+private:
+    AllocationCounter* counter_ = nullptr;
+
+    static size_t ComputeOverhead(const T* data, size_t bytes) {
+        // A malloc chunk has a size word in front of the usable part
+        static constexpr size_t CHUNK_HEADER_BYTES = sizeof(size_t);
+#if defined(__GLIBC__)
+        return malloc_usable_size(const_cast<T*>(data)) - bytes + CHUNK_HEADER_BYTES;
+#else
+        static constexpr size_t CHUNK_ALIGNMENT = 2 * sizeof(size_t);
+        const size_t chunk_bytes = (bytes + CHUNK_HEADER_BYTES + CHUNK_ALIGNMENT - 1) / CHUNK_ALIGNMENT * CHUNK_ALIGNMENT;
+        return chunk_bytes - bytes;
+#endif
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const CountingAllocator<T>& lhs, const CountingAllocator<U>& rhs) noexcept {
+    return lhs.GetCounter() == rhs.GetCounter();
+}
+
+template <typename T, typename U>
+bool operator!=(const CountingAllocator<T>& lhs, const CountingAllocator<U>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template <typename Key, typename Value>
+using CountedMap = std::map<Key, Value, std::less<Key>, CountingAllocator<std::pair<const Key, Value>>>;
+
+template <typename Key>
+using CountedSet = std::set<Key, std::less<Key>, CountingAllocator<Key>>;
+
+using CountedString = std::basic_string<char, std::char_traits<char>, CountingAllocator<char>>;
+
+inline StructureMemory ReadAllocationCounter(const AllocationCounter& counter) {
+    StructureMemory memory;
+    memory.bytes = counter.bytes.load(std::memory_order_relaxed);
+    memory.overhead_bytes = counter.overhead_bytes.load(std::memory_order_relaxed);
+    memory.allocation_count = counter.allocation_count.load(std::memory_order_relaxed);
+    return memory;
+}
@@ -0,0 +1,266 @@
+#include "ordinal_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+void OrdinalIndex::AddDocument(const OrdinalDocument& document,
+                               const WordFrequenciesView& word_freqs) {
+    const auto ordinal = static_cast<uint32_t>(documents_.size());
+    documents_.push_back(document);
+    id_to_ordinal_[document.id] = ordinal;
+    posting_count_ += word_freqs.size();
+    for (const auto& [word, term_freq] : word_freqs) {
+        auto& postings = word_to_postings_[word];
+        postings.ordinals.push_back(ordinal);
+        postings.term_freqs.push_back(term_freq);
+        UpdateBlockSummaries(postings, (postings.ordinals.size() - 1) / ORDINAL_BLOCK_SIZE);
+    }
+}
+
+void OrdinalIndex::RemoveDocument(int document_id, const WordFrequenciesView& word_freqs) {
+    const auto ordinal_it = id_to_ordinal_.find(document_id);
+    if (ordinal_it == id_to_ordinal_.end()) {
+        return;
+    }
+    documents_[ordinal_it->second] = OrdinalDocument{};
+    id_to_ordinal_.erase(ordinal_it);
+    removed_posting_count_ += word_freqs.size();
+    if (removed_posting_count_ * 2 > posting_count_) {
+        Compact();
+    }
+}
+
+void OrdinalIndex::Compact() {
+    for (auto it = word_to_postings_.begin(); it != word_to_postings_.end();) {
+        OrdinalPostings& postings = it->second;
+        size_t kept = 0;
+        for (size_t i = 0; i < postings.ordinals.size(); ++i) {
+            if (documents_[postings.ordinals[i]].id != OrdinalDocument::REMOVED_ID) {
+                postings.ordinals[kept] = postings.ordinals[i];
+                postings.term_freqs[kept] = postings.term_freqs[i];
+                ++kept;
+            }
+        }
+        if (kept == 0) {
+            it = word_to_postings_.erase(it);
+            continue;
+        }
+        postings.ordinals.resize(kept);
+        postings.term_freqs.resize(kept);
+        UpdateBlockSummaries(postings, 0);
+        ++it;
+    }
+    posting_count_ -= removed_posting_count_;
+    removed_posting_count_ = 0;
+}
+
+void OrdinalIndex::Reorder() {
+    Compact();
+    BisectionState state;
+    state.document_terms.resize(documents_.size());
+    uint32_t term_count = 0;
+    for (const auto& [word, postings] : word_to_postings_) {
+        // A word of a single document has no gaps to shrink
+        if (postings.ordinals.size() < 2) {
+            continue;
+        }
+        for (const uint32_t ordinal : postings.ordinals) {
+            state.document_terms[ordinal].push_back(term_count);
+        }
+        ++term_count;
+    }
+    state.left_degrees.assign(term_count, 0);
+    state.right_degrees.assign(term_count, 0);
+    state.left_to_right_gains.assign(term_count, 0.0);
+    state.right_to_left_gains.assign(term_count, 0.0);
+
+    std::vector<uint32_t> order;
+    order.reserve(id_to_ordinal_.size());
+    for (uint32_t ordinal = 0; ordinal < documents_.size(); ++ordinal) {
+        if (documents_[ordinal].id != OrdinalDocument::REMOVED_ID) {
+            order.push_back(ordinal);
+        }
+    }
+    const auto partition_key = [this](uint32_t ordinal) {
+        return std::pair{documents_[ordinal].status, documents_[ordinal].rating};
+    };
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) {
+        return partition_key(lhs) < partition_key(rhs);
+    });
+    for (auto status_begin = order.begin(); status_begin != order.end();) {
+        const DocumentStatus status = documents_[*status_begin].status;
+        const auto status_end = std::find_if(status_begin, order.end(), [&](uint32_t ordinal) {
+            return documents_[ordinal].status != status;
+        });
+        const auto status_size = static_cast<size_t>(status_end - status_begin);
+        for (size_t part = 0; part < RATING_PARTITION_COUNT; ++part) {
+            Bisect(status_begin + status_size * part / RATING_PARTITION_COUNT,
+                   status_begin + status_size * (part + 1) / RATING_PARTITION_COUNT, state);
+        }
+        status_begin = status_end;
+    }
+
+    std::vector<uint32_t> old_to_new(documents_.size());
+    std::vector<OrdinalDocument> documents(order.size());
+    for (uint32_t ordinal = 0; ordinal < order.size(); ++ordinal) {
+        old_to_new[order[ordinal]] = ordinal;
+        documents[ordinal] = documents_[order[ordinal]];
+        id_to_ordinal_[documents[ordinal].id] = ordinal;
+    }
+    documents_ = std::move(documents);
+
+    std::vector<std::pair<uint32_t, double>> entries;
+    for (auto& [word, postings] : word_to_postings_) {
+        entries.clear();
+        for (size_t i = 0; i < postings.ordinals.size(); ++i) {
+            entries.push_back({old_to_new[postings.ordinals[i]], postings.term_freqs[i]});
+        }
+        std::sort(entries.begin(), entries.end());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            postings.ordinals[i] = entries[i].first;
+            postings.term_freqs[i] = entries[i].second;
+        }
+        UpdateBlockSummaries(postings, 0);
+    }
+}
+
+const OrdinalPostings* OrdinalIndex::Find(std::string_view word) const {
+    const auto it = word_to_postings_.find(word);
+    return it == word_to_postings_.end() ? nullptr : &it->second;
+}
+
+std::optional<uint32_t> OrdinalIndex::FindOrdinal(int document_id) const {
+    const auto it = id_to_ordinal_.find(document_id);
+    if (it == id_to_ordinal_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+const std::vector<OrdinalDocument>& OrdinalIndex::GetDocuments() const {
+    return documents_;
+}
+
+DocumentOrderStats OrdinalIndex::GetStats() const {
+    DocumentOrderStats stats;
+    stats.ordinal_count = documents_.size();
+    stats.array_bytes = documents_.capacity() * sizeof(OrdinalDocument);
+    double total_gap_bits = 0.0;
+    for (const auto& [word, postings] : word_to_postings_) {
+        uint32_t previous = 0;
+        for (size_t i = 0; i < postings.ordinals.size(); ++i) {
+            // The first gap is counted from -1 so that it is never zero
+            const uint32_t gap = i == 0 ? postings.ordinals[i] + 1 : postings.ordinals[i] - previous;
+            previous = postings.ordinals[i];
+            total_gap_bits += std::log2(gap);
+            stats.gap_bytes += gap < (1u << 7) ? 1 : gap < (1u << 14) ? 2 : gap < (1u << 21) ? 3 : gap < (1u << 28) ? 4 : 5;
+        }
+        stats.posting_count += postings.ordinals.size();
+        stats.array_bytes += postings.ordinals.capacity() * sizeof(uint32_t)
+                             + postings.term_freqs.capacity() * sizeof(double)
+                             + postings.blocks.capacity() * sizeof(PostingsBlockSummary);
+    }
+    if (stats.posting_count > 0) {
+        stats.average_gap_bits = total_gap_bits / stats.posting_count;
+    }
+    return stats;
+}
+
+void OrdinalIndex::UpdateBlockSummaries(OrdinalPostings& postings, size_t first_block) const {
+    const size_t block_count = (postings.ordinals.size() + ORDINAL_BLOCK_SIZE - 1) / ORDINAL_BLOCK_SIZE;
+    postings.blocks.resize(block_count);
+    for (size_t block = first_block; block < block_count; ++block) {
+        PostingsBlockSummary summary;
+        summary.min_rating = std::numeric_limits<int>::max();
+        summary.max_rating = std::numeric_limits<int>::min();
+        const size_t end = std::min((block + 1) * ORDINAL_BLOCK_SIZE, postings.ordinals.size());
+        for (size_t i = block * ORDINAL_BLOCK_SIZE; i < end; ++i) {
+            const OrdinalDocument& document = documents_[postings.ordinals[i]];
+            summary.status_mask |= 1u << static_cast<int>(document.status);
+            summary.min_rating = std::min(summary.min_rating, document.rating);
+            summary.max_rating = std::max(summary.max_rating, document.rating);
+        }
+        postings.blocks[block] = summary;
+    }
+}
+
+void OrdinalIndex::Bisect(std::vector<uint32_t>::iterator begin, std::vector<uint32_t>::iterator end,
+                          BisectionState& state) {
+    const auto size = static_cast<size_t>(end - begin);
+    if (size <= MIN_BISECTION_SIZE) {
+        return;
+    }
+    const auto middle = begin + size / 2;
+    const size_t left_size = size / 2;
+    const size_t right_size = size - left_size;
+
+    std::vector<std::pair<double, uint32_t>> left_gains;
+    std::vector<std::pair<double, uint32_t>> right_gains;
+    for (int iteration = 0; iteration < BISECTION_ITERATIONS; ++iteration) {
+        for (auto it = begin; it != end; ++it) {
+            auto& degrees = it < middle ? state.left_degrees : state.right_degrees;
+            for (const uint32_t term : state.document_terms[*it]) {
+                ++degrees[term];
+            }
+        }
+        // Gains of moving one document with the term to the other half; degrees
+        // are zeroed on the way so the next pass starts clean
+        for (auto it = begin; it != end; ++it) {
+            for (const uint32_t term : state.document_terms[*it]) {
+                const uint32_t left = state.left_degrees[term];
+                const uint32_t right = state.right_degrees[term];
+                if (left + right == 0) {
+                    continue;
+                }
+                const double cost = ComputeGapCost(left, left_size) + ComputeGapCost(right, right_size);
+                state.left_to_right_gains[term] = left == 0 ? 0.0
+                        : cost - ComputeGapCost(left - 1, left_size) - ComputeGapCost(right + 1, right_size);
+                state.right_to_left_gains[term] = right == 0 ? 0.0
+                        : cost - ComputeGapCost(left + 1, left_size) - ComputeGapCost(right - 1, right_size);
+                state.left_degrees[term] = 0;
+                state.right_degrees[term] = 0;
+            }
+        }
+        left_gains.clear();
+        right_gains.clear();
+        for (auto it = begin; it != end; ++it) {
+            const bool is_left = it < middle;
+            const auto& term_gains = is_left ? state.left_to_right_gains : state.right_to_left_gains;
+            double gain = 0.0;
+            for (const uint32_t term : state.document_terms[*it]) {
+                gain += term_gains[term];
+            }
+            (is_left ? left_gains : right_gains).push_back({gain, *it});
+        }
+        // Best candidates first, ties by ordinal to keep the result deterministic
+        const auto by_gain = [](const std::pair<double, uint32_t>& lhs, const std::pair<double, uint32_t>& rhs) {
+            return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+        };
+        std::sort(left_gains.begin(), left_gains.end(), by_gain);
+        std::sort(right_gains.begin(), right_gains.end(), by_gain);
+        size_t swap_count = 0;
+        while (swap_count < left_gains.size() && swap_count < right_gains.size()
+               && left_gains[swap_count].first + right_gains[swap_count].first > 0.0) {
+            std::swap(left_gains[swap_count].second, right_gains[swap_count].second);
+            ++swap_count;
+        }
+        if (swap_count == 0) {
+            break;
+        }
+        auto it = begin;
+        for (const auto& [_, ordinal] : left_gains) {
+            *it++ = ordinal;
+        }
+        for (const auto& [_, ordinal] : right_gains) {
+            *it++ = ordinal;
+        }
+    }
+    Bisect(begin, middle, state);
+    Bisect(middle, end, state);
+}
+
+double OrdinalIndex::ComputeGapCost(uint32_t degree, size_t size) {
+    return degree == 0 ? 0.0 : degree * std::log2(static_cast<double>(size) / (degree + 1));
+}
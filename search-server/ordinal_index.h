@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+#include "forward_index.h"
+
+// What scoring reads about a document, stored per ordinal
+struct OrdinalDocument {
+    static constexpr int REMOVED_ID = -1;
+
+    int id = REMOVED_ID;  // until the next Reorder() for a removed document
+    int rating = 0;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    uint32_t word_count = 0;
+};
+
+// Statuses and rating range of the documents of a postings block
+struct PostingsBlockSummary {
+    uint32_t status_mask = 0;  // bit i set: some document has status i
+    int min_rating = 0;
+    int max_rating = 0;
+};
+
+const size_t ORDINAL_BLOCK_SIZE = 64;
+
+// Postings of a word in ascending ordinal order, summarized per
+// ORDINAL_BLOCK_SIZE postings
+struct OrdinalPostings {
+    std::vector<uint32_t> ordinals;
+    std::vector<double> term_freqs;
+    std::vector<PostingsBlockSummary> blocks;
+};
+
+struct DocumentOrderStats {
+    size_t ordinal_count = 0;       // including ordinals of removed documents
+    size_t posting_count = 0;       // including postings of removed documents not compacted yet
+    size_t gap_bytes = 0;           // ordinals stored as varint-encoded gaps
+    double average_gap_bits = 0.0;  // average log2 of a gap
+    // Capacity of the postings, block summary and document arrays, all on top
+    // of the inverted index; map nodes are not counted
+    size_t array_bytes = 0;
+};
+
+// Maps external document ids to dense internal ordinals and keeps postings
+// keyed by ordinal in flat arrays. This is a second copy of every posting next
+// to the inverted index of SearchServer, which still serves everything else. A new document takes the next ordinal, so
+// appending keeps every list sorted; Reorder() renumbers all documents.
+// Removing a document only marks its ordinal: its postings are dropped in one
+// pass once removed postings outnumber live ones, or by Reorder(). Until then
+// block summaries may still count them, which only makes them less selective.
+class OrdinalIndex {
+public:
+    void AddDocument(const OrdinalDocument& document, const WordFrequenciesView& word_freqs);
+
+    void RemoveDocument(int document_id, const WordFrequenciesView& word_freqs);
+
+    // Groups documents by status, then by rating into RATING_PARTITION_COUNT
+    // equal parts, so block summaries let filters skip most blocks. Inside a
+    // part, recursive graph bisection splits the documents in two halves, swaps
+    // documents between them while that lowers the estimated log-gap cost of
+    // the postings, then does the same inside each half. Ordinals of removed
+    // documents are dropped.
+    void Reorder();
+
+    // nullptr if no document has the word
+    const OrdinalPostings* Find(std::string_view word) const;
+
+    std::optional<uint32_t> FindOrdinal(int document_id) const;
+
+    // Indexed by ordinal
+    const std::vector<OrdinalDocument>& GetDocuments() const;
+
+    DocumentOrderStats GetStats() const;
+
+private:
+    static constexpr size_t RATING_PARTITION_COUNT = 8;
+    static constexpr size_t MIN_BISECTION_SIZE = 16;
+    static constexpr int BISECTION_ITERATIONS = 10;
+
+    // Scratch space shared by all levels of Reorder()
+    struct BisectionState {
+        std::vector<std::vector<uint32_t>> document_terms;  // by old ordinal, terms present in 2+ documents
+        std::vector<uint32_t> left_degrees;
+        std::vector<uint32_t> right_degrees;
+        std::vector<double> left_to_right_gains;
+        std::vector<double> right_to_left_gains;
+    };
+
+    std::vector<OrdinalDocument> documents_;
+    std::unordered_map<int, uint32_t> id_to_ordinal_;
+    std::map<std::string_view, OrdinalPostings> word_to_postings_;
+    size_t posting_count_ = 0;
+    size_t removed_posting_count_ = 0;
+
+    // Drops postings of removed documents, keeping the ordinals of the others
+    void Compact();
+    // Recomputes summaries of the blocks from first_block on
+    void UpdateBlockSummaries(OrdinalPostings& postings, size_t first_block) const;
+
+    static void Bisect(std::vector<uint32_t>::iterator begin, std::vector<uint32_t>::iterator end,
+                       BisectionState& state);
+    // Estimated bits for the gaps of a term with degree documents among size ones
+    static double ComputeGapCost(uint32_t degree, size_t size);
+};
@@ -1,14 +1,19 @@
 #pragma once
+#include <algorithm>
 #include <iostream>
-#include <vector>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+using namespace std::string_literals;
 
 template <typename Iterator>
 class IteratorRange {
 public:
-    IteratorRange(Iterator& range_begin, Iterator& range_end)
+    IteratorRange(Iterator range_begin, Iterator range_end)
             : begin_(range_begin)
-            , end_(range_end)
-            , size_(distance(range_begin, range_end)) {
+            , end_(range_end) {
     }
 
     auto begin() const {
@@ -19,37 +24,106 @@ public:
         return end_;
     }
 
-    size_t size() {
-        return size_;
+    size_t size() const {
+        return std::distance(begin_, end_);
     }
 
 private:
     Iterator begin_, end_;
-    size_t size_;
 };
 
+// Pages over [documents_begin, documents_end) without copying the documents.
+// A page is found when the iteration reaches it, so taking the first pages
+// of a long range costs only their size.
 template <typename Iterator>
 class Paginator {
 public:
-    Paginator(Iterator documents_begin, Iterator documents_end, int page_size) {
-        while(distance(documents_begin, documents_end) > page_size) {
-            auto it_current = documents_begin;
-            advance(documents_begin, page_size);
-            pages_.push_back(IteratorRange(it_current, documents_begin));
+    class PageIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = IteratorRange<Iterator>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        PageIterator(Iterator page_begin, Iterator documents_end, size_t page_size)
+                : page_(page_begin, AdvanceAtMost(page_begin, documents_end, page_size))
+                , documents_end_(documents_end)
+                , page_size_(page_size) {
+        }
+
+        reference operator*() const {
+            return page_;
+        }
+
+        pointer operator->() const {
+            return &page_;
+        }
+
+        PageIterator& operator++() {
+            const Iterator page_begin = page_.end();
+            page_ = value_type(page_begin, AdvanceAtMost(page_begin, documents_end_, page_size_));
+            return *this;
+        }
+
+        PageIterator operator++(int) {
+            PageIterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const PageIterator& other) const {
+            return page_.begin() == other.page_.begin();
+        }
+
+        bool operator!=(const PageIterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        value_type page_;
+        Iterator documents_end_;
+        size_t page_size_;
+    };
+
+    Paginator(Iterator documents_begin, Iterator documents_end, size_t page_size)
+            : documents_begin_(documents_begin)
+            , documents_end_(documents_end)
+            , page_size_(page_size) {
+        if (page_size == 0) {
+            throw std::invalid_argument("Page size must be positive"s);
         }
-        pages_.push_back(IteratorRange(documents_begin, documents_end));
     }
 
-    auto begin() const {
-        return pages_.begin();
+    PageIterator begin() const {
+        return {documents_begin_, documents_end_, page_size_};
     }
 
-    auto end() const {
-        return pages_.end();
+    PageIterator end() const {
+        return {documents_end_, documents_end_, page_size_};
+    }
+
+    // Number of pages; walks the range unless its iterators are random access
+    size_t size() const {
+        return (std::distance(documents_begin_, documents_end_) + page_size_ - 1) / page_size_;
     }
 
 private:
-    std::vector<IteratorRange<Iterator>> pages_;
+    Iterator documents_begin_;
+    Iterator documents_end_;
+    size_t page_size_;
+
+    static Iterator AdvanceAtMost(Iterator it, Iterator end, size_t count) {
+        if constexpr (std::is_base_of_v<std::random_access_iterator_tag,
+                                        typename std::iterator_traits<Iterator>::iterator_category>) {
+            return it + std::min<typename std::iterator_traits<Iterator>::difference_type>(count, end - it);
+        } else {
+            for (; count > 0 && it != end; --count) {
+                ++it;
+            }
+            return it;
+        }
+    }
 };
 
 template <typename Container>
@@ -63,4 +137,4 @@ std::ostream& operator<<(std::ostream& output, const IteratorRange<Iterator>& pa
         output << *it;
     }
     return output;
-}
\ No newline at end of file
+}
@@ -0,0 +1,95 @@
+#include "perfect_hash.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+using namespace std::string_literals;
+
+PerfectHash::PerfectHash(std::vector<std::string_view> keys) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    if (keys.empty()) {
+        return;
+    }
+    size_t key_bytes = 0;
+    for (const std::string_view key : keys) {
+        key_bytes += key.size();
+    }
+    if (keys.size() >= DIRECT_SLOT || key_bytes > UINT32_MAX) {
+        throw std::length_error("Too many keys for a perfect hash"s);
+    }
+    for (const std::string_view key : keys) {
+        length_mask_ |= 1ull << std::min(key.size(), MAX_MASKED_LENGTH);
+        if (!key.empty()) {
+            const auto first_byte = static_cast<uint8_t>(key[0]);
+            first_byte_mask_[first_byte >> 6] |= 1ull << (first_byte & 63);
+        }
+    }
+
+    // Two keys per bucket on average
+    const size_t key_count = keys.size();
+    buckets_.assign(std::max<size_t>(1, key_count / 2), 0);
+    std::vector<uint64_t> hashes(key_count);
+    std::vector<std::vector<size_t>> bucket_keys(buckets_.size());
+    for (size_t i = 0; i < key_count; ++i) {
+        hashes[i] = Hash(keys[i]);
+        bucket_keys[Reduce(hashes[i] >> 32, buckets_.size())].push_back(i);
+    }
+    // Large buckets are placed first, while most slots are still free
+    std::vector<size_t> bucket_order(buckets_.size());
+    std::iota(bucket_order.begin(), bucket_order.end(), 0);
+    std::stable_sort(bucket_order.begin(), bucket_order.end(), [&bucket_keys](size_t lhs, size_t rhs) {
+        return bucket_keys[lhs].size() > bucket_keys[rhs].size();
+    });
+
+    std::vector<size_t> slot_keys(key_count);
+    std::vector<bool> is_taken(key_count, false);
+    std::vector<size_t> slots;
+    size_t next_free_slot = 0;
+    for (const size_t bucket : bucket_order) {
+        const std::vector<size_t>& members = bucket_keys[bucket];
+        if (members.empty()) {
+            break;
+        }
+        if (members.size() == 1) {
+            while (is_taken[next_free_slot]) {
+                ++next_free_slot;
+            }
+            is_taken[next_free_slot] = true;
+            slot_keys[next_free_slot] = members[0];
+            buckets_[bucket] = DIRECT_SLOT | static_cast<uint32_t>(next_free_slot);
+            continue;
+        }
+        for (uint32_t seed = 0;; ++seed) {
+            if (seed == DIRECT_SLOT) {
+                throw std::runtime_error("Can't build a perfect hash"s);
+            }
+            slots.clear();
+            for (const size_t key : members) {
+                const size_t slot = Reduce(Mix(hashes[key], seed), key_count);
+                if (is_taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (slots.size() == members.size()) {
+                for (size_t i = 0; i < slots.size(); ++i) {
+                    is_taken[slots[i]] = true;
+                    slot_keys[slots[i]] = members[i];
+                }
+                buckets_[bucket] = seed;
+                break;
+            }
+        }
+    }
+
+    key_data_.reserve(key_bytes);
+    key_offsets_.reserve(key_count + 1);
+    for (const size_t key : slot_keys) {
+        key_offsets_.push_back(static_cast<uint32_t>(key_data_.size()));
+        key_data_ += keys[key];
+    }
+    key_offsets_.push_back(static_cast<uint32_t>(key_data_.size()));
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Minimal perfect hash over a fixed set of strings (hash and displace): keys
+// are spread over buckets by one hash, and every bucket gets a seed sending
+// its keys to distinct free slots, or the slot itself for a bucket of one key.
+// A lookup is one hash of the key, one bucket read and one key comparison;
+// keys whose length or first byte no key has are rejected without hashing.
+// Keys are copied into one buffer, so the hash can be moved and copied freely.
+class PerfectHash {
+public:
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    PerfectHash() = default;
+    // Duplicate keys take one slot
+    explicit PerfectHash(std::vector<std::string_view> keys);
+
+    // Slot of key in [0, size()), or NOT_FOUND
+    size_t Find(std::string_view key) const;
+
+    // slot must be in [0, size())
+    std::string_view GetKey(size_t slot) const;
+
+    size_t size() const;
+
+private:
+    // Bucket entries with this bit hold the slot of their only key
+    static constexpr uint32_t DIRECT_SLOT = 1u << 31;
+    static constexpr size_t MAX_MASKED_LENGTH = 63;
+
+    std::string key_data_;                // keys by slot, back to back
+    std::vector<uint32_t> key_offsets_;   // key_offsets_[slot], key_offsets_[slot + 1] bound a key
+    std::vector<uint32_t> buckets_;
+    uint64_t length_mask_ = 0;
+    std::array<uint64_t, 4> first_byte_mask_{};
+
+    bool MayContain(std::string_view key) const;
+
+    static uint64_t Hash(std::string_view key);
+    static uint64_t Mix(uint64_t hash, uint32_t seed);
+    // Maps 32 bits of value onto [0, size) without a division
+    static size_t Reduce(uint64_t value, size_t size);
+};
+
+inline size_t PerfectHash::Find(std::string_view key) const {
+    if (!MayContain(key)) {
+        return NOT_FOUND;
+    }
+    const uint64_t hash = Hash(key);
+    const uint32_t bucket = buckets_[Reduce(hash >> 32, buckets_.size())];
+    const size_t slot = (bucket & DIRECT_SLOT) != 0 ? bucket & ~DIRECT_SLOT
+                                                    : Reduce(Mix(hash, bucket), size());
+    return GetKey(slot) == key ? slot : NOT_FOUND;
+}
+
+inline std::string_view PerfectHash::GetKey(size_t slot) const {
+    return std::string_view(key_data_).substr(key_offsets_[slot], key_offsets_[slot + 1] - key_offsets_[slot]);
+}
+
+inline size_t PerfectHash::size() const {
+    return key_offsets_.empty() ? 0 : key_offsets_.size() - 1;
+}
+
+inline bool PerfectHash::MayContain(std::string_view key) const {
+    if (key_offsets_.empty()) {
+        return false;
+    }
+    const size_t length = key.size() < MAX_MASKED_LENGTH ? key.size() : MAX_MASKED_LENGTH;
+    if ((length_mask_ >> length & 1) == 0) {
+        return false;
+    }
+    if (key.empty()) {
+        return true;
+    }
+    const auto first_byte = static_cast<uint8_t>(key[0]);
+    return (first_byte_mask_[first_byte >> 6] >> (first_byte & 63) & 1) != 0;
+}
+
+inline uint64_t PerfectHash::Hash(std::string_view key) {
+    static constexpr uint64_t MULTIPLIER = 0xFF51AFD7ED558CCDull;
+    uint64_t hash = key.size() * 0x9E3779B97F4A7C15ull;
+    size_t offset = 0;
+    for (; offset + 8 <= key.size(); offset += 8) {
+        uint64_t chunk;
+        std::memcpy(&chunk, key.data() + offset, 8);
+        hash = (hash ^ chunk) * MULTIPLIER;
+        hash ^= hash >> 32;
+    }
+    if (offset < key.size()) {
+        uint64_t chunk = 0;
+        std::memcpy(&chunk, key.data() + offset, key.size() - offset);
+        hash = (hash ^ chunk) * MULTIPLIER;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+inline uint64_t PerfectHash::Mix(uint64_t hash, uint32_t seed) {
+    hash ^= (seed + 1ull) * 0x9E3779B97F4A7C15ull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+inline size_t PerfectHash::Reduce(uint64_t value, size_t size) {
+    return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(value)) * size) >> 32);
+}
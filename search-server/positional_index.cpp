@@ -0,0 +1,227 @@
+#include "positional_index.h"
+
+#include <algorithm>
+#include <limits>
+
+void PositionalIndex::AddDocument(int document_id, const std::vector<std::string_view>& words) {
+    std::map<std::string_view, std::vector<uint32_t>> word_positions;
+    for (uint32_t position = 0; position < words.size(); ++position) {
+        word_positions[words[position]].push_back(position);
+    }
+    for (const auto& [word, positions] : word_positions) {
+        word_to_document_positions_[word][document_id] = EncodePositions(positions);
+    }
+}
+
+std::vector<int> PositionalIndex::FindPhraseDocuments(const std::vector<std::string_view>& phrase) const {
+    std::vector<int> result;
+    if (phrase.empty()) {
+        return result;
+    }
+    // Phrase word postings together with the word offset inside the phrase
+    std::vector<std::pair<const DocumentPositions*, size_t>> postings;
+    postings.reserve(phrase.size());
+    for (size_t offset = 0; offset < phrase.size(); ++offset) {
+        const auto word_it = word_to_document_positions_.find(phrase[offset]);
+        if (word_it == word_to_document_positions_.end()) {
+            return result;
+        }
+        postings.push_back({&word_it->second, offset});
+    }
+    // The shortest postings list proposes documents, the others seek to them
+    std::sort(postings.begin(), postings.end(),
+              [](const auto& lhs, const auto& rhs) {
+                  return lhs.first->size() < rhs.first->size();
+              });
+    std::vector<DocumentPositions::const_iterator> cursors;
+    cursors.reserve(postings.size());
+    for (const auto& [document_postings, offset] : postings) {
+        cursors.push_back(document_postings->begin());
+    }
+
+    // Positions are decoded only for documents having every phrase word
+    std::vector<std::vector<uint32_t>> positions(phrase.size());
+    while (cursors.front() != postings.front().first->end()) {
+        int document_id = cursors.front()->first;
+        bool is_common = true;
+        for (size_t i = 1; i < cursors.size(); ++i) {
+            SeekDocument(*postings[i].first, cursors[i], document_id);
+            if (cursors[i] == postings[i].first->end()) {
+                return result;
+            }
+            if (cursors[i]->first != document_id) {
+                document_id = cursors[i]->first;
+                is_common = false;
+                break;
+            }
+        }
+        if (!is_common) {
+            SeekDocument(*postings.front().first, cursors.front(), document_id);
+            continue;
+        }
+        for (size_t i = 0; i < cursors.size(); ++i) {
+            positions[postings[i].second] = DecodePositions(cursors[i]->second);
+        }
+        if (HasPhraseMatch(positions)) {
+            result.push_back(document_id);
+        }
+        ++cursors.front();
+    }
+    return result;
+}
+
+bool PositionalIndex::ContainsPhrase(int document_id, const std::vector<std::string_view>& phrase) const {
+    if (phrase.empty()) {
+        return false;
+    }
+    std::vector<std::vector<uint32_t>> positions;
+    positions.reserve(phrase.size());
+    for (const std::string_view word : phrase) {
+        const EncodedPositions* encoded = FindPositions(word, document_id);
+        if (encoded == nullptr) {
+            return false;
+        }
+        positions.push_back(DecodePositions(*encoded));
+    }
+    return HasPhraseMatch(positions);
+}
+
+bool PositionalIndex::IsNear(int document_id, std::string_view lhs, std::string_view rhs, int max_distance) const {
+    const EncodedPositions* lhs_encoded = FindPositions(lhs, document_id);
+    const EncodedPositions* rhs_encoded = FindPositions(rhs, document_id);
+    if (lhs_encoded == nullptr || rhs_encoded == nullptr) {
+        return false;
+    }
+    const uint32_t distance = ComputeMinDistance(DecodePositions(*lhs_encoded), DecodePositions(*rhs_encoded));
+    return distance <= static_cast<uint32_t>(max_distance);
+}
+
+PositionalIndexStats PositionalIndex::GetStats() const {
+    // Rough per-node cost of a std::map node: three pointers and a color word
+    static constexpr size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+
+    PositionalIndexStats stats;
+    for (const auto& [word, document_positions] : word_to_document_positions_) {
+        stats.total_bytes += MAP_NODE_OVERHEAD + sizeof(word) + sizeof(document_positions);
+        for (const auto& [document_id, encoded] : document_positions) {
+            const size_t count = CountPositions(encoded);
+            ++stats.posting_count;
+            stats.position_count += count;
+            stats.encoded_bytes += encoded.capacity();
+            stats.raw_bytes += count * sizeof(uint32_t);
+            stats.total_bytes += MAP_NODE_OVERHEAD + sizeof(document_id) + sizeof(encoded) + encoded.capacity();
+        }
+    }
+    return stats;
+}
+
+PositionalIndex::EncodedPositions PositionalIndex::EncodePositions(const std::vector<uint32_t>& positions) {
+    EncodedPositions data;
+    data.reserve(positions.size());
+    uint32_t previous = 0;
+    for (const uint32_t position : positions) {
+        uint32_t delta = position - previous;
+        previous = position;
+        while (delta >= 0x80) {
+            data.push_back(static_cast<uint8_t>(delta | 0x80));
+            delta >>= 7;
+        }
+        data.push_back(static_cast<uint8_t>(delta));
+    }
+    data.shrink_to_fit();
+    return data;
+}
+
+std::vector<uint32_t> PositionalIndex::DecodePositions(const EncodedPositions& data) {
+    std::vector<uint32_t> positions;
+    positions.reserve(data.size());
+    uint32_t previous = 0;
+    uint32_t delta = 0;
+    int shift = 0;
+    for (const uint8_t byte : data) {
+        delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (byte & 0x80) {
+            shift += 7;
+            continue;
+        }
+        previous += delta;
+        positions.push_back(previous);
+        delta = 0;
+        shift = 0;
+    }
+    return positions;
+}
+
+size_t PositionalIndex::CountPositions(const EncodedPositions& data) {
+    return std::count_if(data.begin(), data.end(), [](uint8_t byte) { return (byte & 0x80) == 0; });
+}
+
+const PositionalIndex::EncodedPositions* PositionalIndex::FindPositions(std::string_view word, int document_id) const {
+    const auto word_it = word_to_document_positions_.find(word);
+    if (word_it == word_to_document_positions_.end()) {
+        return nullptr;
+    }
+    const auto document_it = word_it->second.find(document_id);
+    if (document_it == word_it->second.end()) {
+        return nullptr;
+    }
+    return &document_it->second;
+}
+
+void PositionalIndex::SeekDocument(const DocumentPositions& postings, DocumentPositions::const_iterator& it,
+                                   int document_id) {
+    // Close documents are reached by stepping, far ones by a tree search
+    static constexpr int MAX_STEPS = 8;
+    for (int step = 0; step < MAX_STEPS; ++step) {
+        if (it == postings.end() || it->first >= document_id) {
+            return;
+        }
+        ++it;
+    }
+    if (it != postings.end() && it->first < document_id) {
+        it = postings.lower_bound(document_id);
+    }
+}
+
+bool PositionalIndex::HasPhraseMatch(const std::vector<std::vector<uint32_t>>& positions) {
+    // positions[i] must contain start + i for some start; every list is sorted,
+    // so each cursor only moves forward and the whole check is linear
+    std::vector<size_t> cursors(positions.size(), 0);
+    uint32_t start = 0;
+    size_t i = 0;
+    while (i < positions.size()) {
+        const auto& list = positions[i];
+        size_t& cursor = cursors[i];
+        const uint32_t wanted = start + static_cast<uint32_t>(i);
+        while (cursor < list.size() && list[cursor] < wanted) {
+            ++cursor;
+        }
+        if (cursor == list.size()) {
+            return false;
+        }
+        if (list[cursor] == wanted) {
+            ++i;
+            continue;
+        }
+        // list[cursor] > wanted: shift the phrase start and recheck from the first word
+        start = list[cursor] - static_cast<uint32_t>(i);
+        i = 0;
+    }
+    return true;
+}
+
+uint32_t PositionalIndex::ComputeMinDistance(const std::vector<uint32_t>& lhs, const std::vector<uint32_t>& rhs) {
+    uint32_t result = std::numeric_limits<uint32_t>::max();
+    size_t i = 0;
+    size_t j = 0;
+    while (i < lhs.size() && j < rhs.size()) {
+        if (lhs[i] < rhs[j]) {
+            result = std::min(result, rhs[j] - lhs[i]);
+            ++i;
+        } else {
+            result = std::min(result, lhs[i] - rhs[j]);
+            ++j;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string_view>
+#include <vector>
+
+// Positions are counted over the words left after stop words removal
+struct PositionalIndexStats {
+    size_t posting_count = 0;   // number of (word, document) pairs
+    size_t position_count = 0;  // number of stored word occurrences
+    size_t encoded_bytes = 0;   // size of varint-encoded position lists
+    size_t raw_bytes = 0;       // size the same lists would take as plain uint32_t
+    size_t total_bytes = 0;     // encoded lists plus estimated container overhead
+};
+
+class PositionalIndex {
+public:
+    void AddDocument(int document_id, const std::vector<std::string_view>& words);
+
+    template <typename WordContainer>
+    void RemoveDocument(int document_id, const WordContainer& words);
+
+    // Sorted ids of documents containing all phrase words at consecutive positions
+    std::vector<int> FindPhraseDocuments(const std::vector<std::string_view>& phrase) const;
+
+    bool ContainsPhrase(int document_id, const std::vector<std::string_view>& phrase) const;
+
+    // Both words occur within max_distance positions of each other, in any order
+    bool IsNear(int document_id, std::string_view lhs, std::string_view rhs, int max_distance) const;
+
+    PositionalIndexStats GetStats() const;
+
+private:
+    // Delta + varint encoded ascending positions
+    using EncodedPositions = std::vector<uint8_t>;
+
+    using DocumentPositions = std::map<int, EncodedPositions>;
+
+    std::map<std::string_view, DocumentPositions> word_to_document_positions_;
+
+    static EncodedPositions EncodePositions(const std::vector<uint32_t>& positions);
+    static std::vector<uint32_t> DecodePositions(const EncodedPositions& data);
+    static size_t CountPositions(const EncodedPositions& data);
+
+    const EncodedPositions* FindPositions(std::string_view word, int document_id) const;
+    // Moves it forward to the first document not less than document_id
+    static void SeekDocument(const DocumentPositions& postings, DocumentPositions::const_iterator& it,
+                             int document_id);
+
+    static bool HasPhraseMatch(const std::vector<std::vector<uint32_t>>& positions);
+    static uint32_t ComputeMinDistance(const std::vector<uint32_t>& lhs, const std::vector<uint32_t>& rhs);
+};
+
+template <typename WordContainer>
+void PositionalIndex::RemoveDocument(int document_id, const WordContainer& words) {
+    for (const auto& word : words) {
+        const std::string_view word_view = word.first;
+        auto word_it = word_to_document_positions_.find(word_view);
+        if (word_it == word_to_document_positions_.end()) {
+            continue;
+        }
+        word_it->second.erase(document_id);
+        if (word_it->second.empty()) {
+            word_to_document_positions_.erase(word_it);
+        }
+    }
+}
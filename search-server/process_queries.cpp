@@ -19,4 +19,9 @@ std::deque<Document> ProcessQueriesJoined(
         out.insert(out.end(), query_docs.begin(), query_docs.end());
     }
     return out;
+}
+
+std::vector<std::vector<Document>> ProcessQueriesBatched(const SearchServer& search_server,
+                                                         const std::vector<std::string>& queries) {
+    return search_server.FindTopDocumentsBatch(queries);
 }
\ No newline at end of file
@@ -12,5 +12,10 @@ std::vector<std::vector<Document>> ProcessQueries(
         const std::vector<std::string>& queries);
 
 std::deque<Document> ProcessQueriesJoined(
+        const SearchServer& search_server,
+        const std::vector<std::string>& queries);
+
+// Same result as ProcessQueries, computed with SearchServer::FindTopDocumentsBatch
+std::vector<std::vector<Document>> ProcessQueriesBatched(
         const SearchServer& search_server,
         const std::vector<std::string>& queries);
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// Rankings are plain value types passed to FindTopDocuments as a template
+// argument, so their methods are inlined into the postings loop.
+// A ranking provides:
+//   double ComputeWordWeight(const RankingContext&, size_t document_freq) const
+//       once per query word;
+//   double ComputeTermScore(double word_weight, double term_freq, uint32_t document_length,
+//                           const RankingContext&) const
+//       once per posting, term_freq being the share of the document taken by the word;
+//   double FinalizeScore(double relevance, int rating) const
+//       once per matched document.
+
+struct RankingContext {
+    int document_count = 0;
+    double average_document_length = 0.0;
+};
+
+// Current behavior: term_freq * log(document_count / document_freq)
+struct TfIdfRanking {
+    double ComputeWordWeight(const RankingContext& context, size_t document_freq) const {
+        return log(context.document_count * 1.0 / document_freq);
+    }
+
+    double ComputeTermScore(double word_weight, double term_freq, uint32_t /*document_length*/,
+                            const RankingContext& /*context*/) const {
+        return term_freq * word_weight;
+    }
+
+    double FinalizeScore(double relevance, int /*rating*/) const {
+        return relevance;
+    }
+};
+
+// Okapi BM25 with document length normalization
+struct Bm25Ranking {
+    double k1 = 1.2;
+    double b = 0.75;
+
+    double ComputeWordWeight(const RankingContext& context, size_t document_freq) const {
+        const double freq = static_cast<double>(document_freq);
+        return log(1.0 + (context.document_count - freq + 0.5) / (freq + 0.5));
+    }
+
+    double ComputeTermScore(double word_weight, double term_freq, uint32_t document_length,
+                            const RankingContext& context) const {
+        // term_freq is normalized by the document length, BM25 wants the raw count
+        const double count = term_freq * document_length;
+        const double length_ratio = context.average_document_length > 0.0
+                                    ? document_length / context.average_document_length
+                                    : 1.0;
+        return word_weight * count * (k1 + 1.0) / (count + k1 * (1.0 - b + b * length_ratio));
+    }
+
+    double FinalizeScore(double relevance, int /*rating*/) const {
+        return relevance;
+    }
+};
+
+// Adds rating_weight * rating to the score of another ranking
+template <typename BaseRanking>
+struct RatingBoostedRanking {
+    BaseRanking base;
+    double rating_weight = 0.01;
+
+    double ComputeWordWeight(const RankingContext& context, size_t document_freq) const {
+        return base.ComputeWordWeight(context, document_freq);
+    }
+
+    double ComputeTermScore(double word_weight, double term_freq, uint32_t document_length,
+                            const RankingContext& context) const {
+        return base.ComputeTermScore(word_weight, term_freq, document_length, context);
+    }
+
+    double FinalizeScore(double relevance, int rating) const {
+        return base.FinalizeScore(relevance, rating) + rating_weight * rating;
+    }
+};
@@ -1,28 +1,144 @@
 #include "request_queue.h"
 
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// A bucket state is (period + 1) << GENERATION_BITS | generation, zero for a bucket
+// never used. A counter is generation << PAYLOAD_BITS | payload
+constexpr int GENERATION_BITS = 8;
+constexpr uint64_t GENERATION_MASK = (uint64_t{1} << GENERATION_BITS) - 1;
+constexpr int PAYLOAD_BITS = 64 - GENERATION_BITS;
+constexpr uint64_t PAYLOAD_MASK = (uint64_t{1} << PAYLOAD_BITS) - 1;
+// The counts payload holds the requests in its high half and those without results in the low one
+constexpr int COUNT_BITS = PAYLOAD_BITS / 2;
+constexpr uint64_t COUNT_MASK = (uint64_t{1} << COUNT_BITS) - 1;
+
+int64_t GetStatePeriod(uint64_t state) {
+    return static_cast<int64_t>(state >> GENERATION_BITS) - 1;
+}
+
+uint64_t GetGeneration(uint64_t state) {
+    return state & GENERATION_MASK;
+}
+
+// Payload of counter in the bucket state, zero while it still holds an older generation
+uint64_t ReadCounter(const std::atomic<uint64_t>& counter, uint64_t state) {
+    const uint64_t packed = counter.load(std::memory_order_relaxed);
+    return packed >> PAYLOAD_BITS == GetGeneration(state) ? packed & PAYLOAD_MASK : 0;
+}
+
+// Replaces the payload of counter with merge(payload), starting from zero when the counter
+// holds an older generation. Returns false without a change once the bucket has left state
+template <typename Merge>
+bool UpdateCounter(const std::atomic<uint64_t>& bucket_state, uint64_t state,
+                   std::atomic<uint64_t>& counter, Merge merge) {
+    const uint64_t generation = GetGeneration(state);
+    uint64_t packed = counter.load(std::memory_order_relaxed);
+    while (true) {
+        uint64_t counted = 0;
+        if (packed >> PAYLOAD_BITS == generation) {
+            counted = packed & PAYLOAD_MASK;
+        } else if (bucket_state.load(std::memory_order_acquire) != state) {
+            return false;
+        }
+        if (counter.compare_exchange_weak(packed, generation << PAYLOAD_BITS | merge(counted),
+                                          std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+}  // namespace
+
+RequestQueue::RequestQueue(const SearchServer& search_server, std::chrono::nanoseconds window)
+        : search_server_(search_server)
+        , start_time_(Clock::now())
+        , bucket_duration_ns_(window.count() / static_cast<int64_t>(BUCKET_COUNT)) {
+    if (bucket_duration_ns_ <= 0) {
+        throw std::invalid_argument("Request statistics window is too short"s);
+    }
+}
+
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status) {
+    const auto start_time = Clock::now();
     std::vector<Document> result = search_server_.FindTopDocuments(raw_query, status);
-    PushToResultDeque(raw_query, result);
+    RecordRequest(start_time, result.empty());
     return result;
 }
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query) {
+    const auto start_time = Clock::now();
     std::vector<Document> result = search_server_.FindTopDocuments(raw_query);
-    PushToResultDeque(raw_query, result);
+    RecordRequest(start_time, result.empty());
     return result;
 }
 int RequestQueue::GetNoResultRequests() const {
-    int out = 0;
-    for (auto i : requests_) {
-        if (i.result.empty()) {
-            ++out;
+    return GetStats().no_result_count;
+}
+
+RequestStats RequestQueue::GetStats() const {
+    const int64_t current_period = GetPeriod(Clock::now());
+    RequestStats stats;
+    uint64_t request_count = 0;
+    uint64_t no_result_count = 0;
+    uint64_t total_latency_ns = 0;
+    uint64_t max_latency_ns = 0;
+    for (const Bucket& bucket : buckets_) {
+        const uint64_t state = bucket.state.load(std::memory_order_acquire);
+        const int64_t period = GetStatePeriod(state);
+        if (period < 0 || current_period - period >= static_cast<int64_t>(BUCKET_COUNT)) {
+            continue;
         }
+        const uint64_t counts = ReadCounter(bucket.counts, state);
+        request_count += counts >> COUNT_BITS;
+        no_result_count += counts & COUNT_MASK;
+        total_latency_ns += ReadCounter(bucket.total_latency_ns, state);
+        max_latency_ns = std::max(max_latency_ns, ReadCounter(bucket.max_latency_ns, state));
     }
-    return out;
+    stats.request_count = static_cast<int>(request_count);
+    stats.no_result_count = static_cast<int>(no_result_count);
+    if (stats.request_count > 0) {
+        stats.hit_rate = 1.0 - static_cast<double>(stats.no_result_count) / stats.request_count;
+        stats.average_latency = std::chrono::nanoseconds(total_latency_ns / request_count);
+    }
+    stats.max_latency = std::chrono::nanoseconds(max_latency_ns);
+    return stats;
+}
+
+int64_t RequestQueue::GetPeriod(Clock::time_point time) const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time - start_time_).count()
+           / bucket_duration_ns_;
 }
 
-void RequestQueue::PushToResultDeque(const std::string& raw_query, const std::vector<Document>& result) {
-    if (requests_.size() >= min_in_day_) {
-        requests_.pop_front();
+void RequestQueue::RecordRequest(Clock::time_point start_time, bool is_empty) {
+    const auto end_time = Clock::now();
+    const int64_t latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+    const int64_t period = GetPeriod(end_time);
+    Bucket& bucket = buckets_[period % BUCKET_COUNT];
+
+    uint64_t state = bucket.state.load(std::memory_order_acquire);
+    while (GetStatePeriod(state) < period) {
+        const uint64_t next_state = static_cast<uint64_t>(period + 1) << GENERATION_BITS
+                                    | ((GetGeneration(state) + 1) & GENERATION_MASK);
+        if (bucket.state.compare_exchange_weak(state, next_state, std::memory_order_acq_rel)) {
+            state = next_state;
+        }
+    }
+    if (GetStatePeriod(state) > period) {
+        // The bucket counts a later period already, this request is out of the window
+        return;
     }
-    requests_.push_back({raw_query, result});
+    // Every counter is updated, even by zero, so all of them move to the generation together.
+    // Values saturate rather than overflow into their neighbours
+    const auto latency = std::min(static_cast<uint64_t>(std::max<int64_t>(latency_ns, 0)), PAYLOAD_MASK);
+    UpdateCounter(bucket.state, state, bucket.counts, [is_empty](uint64_t counts) {
+        const uint64_t requests = std::min((counts >> COUNT_BITS) + 1, COUNT_MASK);
+        const uint64_t no_results = std::min((counts & COUNT_MASK) + (is_empty ? 1 : 0), requests);
+        return requests << COUNT_BITS | no_results;
+    }) && UpdateCounter(bucket.state, state, bucket.total_latency_ns, [latency](uint64_t total) {
+        return std::min(total + latency, PAYLOAD_MASK);
+    }) && UpdateCounter(bucket.state, state, bucket.max_latency_ns, [latency](uint64_t max_latency) {
+        return std::max(max_latency, latency);
+    });
 }
@@ -1,12 +1,31 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <vector>
 #include "search_server.h"
 
+struct RequestStats {
+    int request_count = 0;
+    int no_result_count = 0;
+    double hit_rate = 0.0;  // share of requests with results
+    std::chrono::nanoseconds average_latency{0};
+    std::chrono::nanoseconds max_latency{0};
+};
+
+// Statistics over the requests of the last `window`. The window is a ring of
+// time buckets with atomic counters: recording is lock-free and safe from many
+// threads, reading sums BUCKET_COUNT buckets. The oldest bucket is dropped as a
+// whole, so the window has a granularity of window / BUCKET_COUNT. A bucket keeps
+// the full period it counts, and its counters are tagged with the generation of
+// that period, so a count from an older period is never mixed into a newer one.
 class RequestQueue {
 public:
-    explicit RequestQueue(const SearchServer& search_server)
-            : search_server_(search_server) {
-    }
+    using Clock = std::chrono::steady_clock;
+
+    explicit RequestQueue(const SearchServer& search_server,
+                          std::chrono::nanoseconds window = std::chrono::hours(24));
     // сделаем "обёртки" для всех методов поиска, чтобы сохранять результаты для нашей статистики
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
@@ -14,21 +33,35 @@ public:
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status) ;
     std::vector<Document> AddFindRequest(const std::string& raw_query);
     int GetNoResultRequests() const;
+    RequestStats GetStats() const;
 
 private:
-    struct QueryResult {
-        std::string query;
-        std::vector<Document> result;
+    static constexpr size_t BUCKET_COUNT = 60;
+
+    // state holds the period of the bucket and a generation that grows by one each
+    // time the bucket moves to a new period. Every counter carries the generation
+    // it counts, so a counter left from an earlier period starts over from zero
+    struct Bucket {
+        std::atomic<uint64_t> state{0};
+        std::atomic<uint64_t> counts{0};  // requests and requests without results, in one word
+        std::atomic<uint64_t> total_latency_ns{0};
+        std::atomic<uint64_t> max_latency_ns{0};
     };
-    std::deque<QueryResult> requests_;
-    const static int min_in_day_ = 1440;
+
     const SearchServer& search_server_;
-    void PushToResultDeque(const std::string& raw_query, const std::vector<Document>& result);
+    const Clock::time_point start_time_;
+    const int64_t bucket_duration_ns_;
+    std::array<Bucket, BUCKET_COUNT> buckets_;
+
+    // Number of whole buckets since the queue was created
+    int64_t GetPeriod(Clock::time_point time) const;
+    void RecordRequest(Clock::time_point start_time, bool is_empty);
 };
 
 template <typename DocumentPredicate>
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
+    const auto start_time = Clock::now();
     std::vector<Document> result = search_server_.FindTopDocuments(raw_query, document_predicate);
-    PushToResultDeque(raw_query, result);
+    RecordRequest(start_time, result.empty());
     return result;
-}
\ No newline at end of file
+}
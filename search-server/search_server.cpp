@@ -1,35 +1,248 @@
 #include "search_server.h"
 
+#include <charconv>
+#include <cstring>
+
 using namespace std::string_literals;
 
 
+SearchServer::SearchServer(const SearchServer& other)
+        : SearchServer(other.stop_words_) {
+    stop_words_text_ = other.stop_words_text_;
+    is_boolean_query_enabled_ = other.is_boolean_query_enabled_;
+    if (other.positional_index_) {
+        EnablePositionalIndex();
+    }
+    for (const int document_id : other.document_ids_) {
+        const DocumentData& document_data = other.documents_.at(document_id);
+        // The average of a single rating is the rating itself
+        AddDocument(document_id, document_data.text, document_data.status, {document_data.rating});
+    }
+    if (other.fuzzy_index_) {
+        EnableFuzzySearch(other.fuzzy_options_);
+    }
+    if (other.impact_index_) {
+        EnableImpactOrderedSearch();
+    }
+    if (other.ordinal_index_) {
+        EnableDocumentOrdinals();
+    }
+    if (other.is_vocabulary_frozen_) {
+        FreezeVocabulary();
+    }
+}
+
+SearchServer::SearchServer(SearchServer&& other)
+        : SearchServer(other.stop_words_) {
+    // Containers are swapped with their allocators, so each keeps counting
+    // into the counters it was built with, now owned by the same server
+    memory_counters_.swap(other.memory_counters_);
+    stop_words_text_.swap(other.stop_words_text_);
+    all_docs_.swap(other.all_docs_);
+    word_to_document_freqs_.swap(other.word_to_document_freqs_);
+    documents_.swap(other.documents_);
+    std::swap(total_word_count_, other.total_word_count_);
+    document_ids_.swap(other.document_ids_);
+    std::swap(is_boolean_query_enabled_, other.is_boolean_query_enabled_);
+    positional_index_.swap(other.positional_index_);
+    std::swap(term_dictionary_, other.term_dictionary_);
+    dictionary_terms_.swap(other.dictionary_terms_);
+    fuzzy_index_.swap(other.fuzzy_index_);
+    impact_index_.swap(other.impact_index_);
+    ordinal_index_.swap(other.ordinal_index_);
+    std::swap(fuzzy_options_, other.fuzzy_options_);
+    std::swap(is_vocabulary_frozen_, other.is_vocabulary_frozen_);
+    std::swap(vocabulary_hash_, other.vocabulary_hash_);
+    vocabulary_postings_.swap(other.vocabulary_postings_);
+}
+
 void SearchServer::AddDocument(int document_id, const std::string_view& document, DocumentStatus status,
                                const std::vector<int>& ratings) {
     if ((document_id < 0) || (documents_.count(document_id) > 0)) {
         throw std::invalid_argument("Invalid document_id"s);
     }
-    all_docs_.push_back(std::string(document));
-    const auto words = SplitIntoWordsNoStop(all_docs_.back());
+    all_docs_.emplace_back(document, all_docs_.get_allocator());
+    const std::string_view text = all_docs_.back();
+    const auto words = SplitIntoWordsNoStop(text);
 
+    // Equal words are grouped, so every distinct word costs one postings
+    // insert and one forward entry; frequencies are summed the same way as
+    // when words were added one at a time
+    std::vector<std::string_view> sorted_words = words;
+    std::sort(sorted_words.begin(), sorted_words.end());
     const double inv_word_count = 1.0 / words.size();
-    for (const std::string_view& word : words) {
-        word_to_document_freqs_[word][document_id] += inv_word_count;
-        id_to_word_freqs_[document_id][word] += inv_word_count;
+    ForwardList forward_words(CountingAllocator<ForwardEntry>(&memory_counters_->forward_index));
+    for (auto word_begin = sorted_words.begin(); word_begin != sorted_words.end();) {
+        const std::string_view word = *word_begin;
+        const auto word_end = std::find_if(word_begin, sorted_words.end(), [word](std::string_view other) {
+            return other != word;
+        });
+        double term_freq = 0.0;
+        for (auto it = word_begin; it != word_end; ++it) {
+            term_freq += inv_word_count;
+        }
+        word_begin = word_end;
+
+        // Nested maps are created with the allocator of the outer one
+        const auto [word_it, is_new_word] =
+                word_to_document_freqs_.try_emplace(word, word_to_document_freqs_.get_allocator());
+        auto& word_postings = word_it->second;
+        if (is_new_word) {
+            term_dictionary_.Insert(word, static_cast<uint32_t>(dictionary_terms_.size()));
+            dictionary_terms_.push_back(word_it);
+        }
+        if (is_new_word && is_vocabulary_frozen_) {
+            is_vocabulary_frozen_ = false;
+            vocabulary_hash_ = {};
+            vocabulary_postings_.clear();
+        }
+        if (word_postings.empty()) {
+            if (fuzzy_index_) {
+                fuzzy_index_->AddTerm(word);
+            }
+            ++memory_counters_->term_count;
+        }
+        word_postings.emplace(document_id, term_freq);
+        forward_words.push_back({static_cast<uint32_t>(word.data() - text.data()),
+                                 static_cast<uint32_t>(word.size()), term_freq});
+    }
+    forward_words.shrink_to_fit();
+    memory_counters_->posting_count += forward_words.size();
+    if (positional_index_) {
+        positional_index_->AddDocument(document_id, words);
     }
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status});
+    if (impact_index_) {
+        for (const auto& [offset, length, _] : forward_words) {
+            impact_index_->Invalidate(text.substr(offset, length));
+        }
+    }
+    const DocumentData& document_data = documents_.emplace(
+            document_id,
+            DocumentData{ComputeAverageRating(ratings), status, static_cast<uint32_t>(words.size()), text,
+                         std::move(forward_words)}).first->second;
+    if (ordinal_index_) {
+        ordinal_index_->AddDocument({document_id, document_data.rating, status, document_data.word_count},
+                                    GetWordFrequencies(document_id));
+    }
+    total_word_count_ += words.size();
     document_ids_.insert(document_id);
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(const std::string_view& raw_query, DocumentStatus status) const {
-    return FindTopDocuments(std::execution::seq, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-    });
+    return FindTopDocuments(std::execution::seq, raw_query, DocumentFilter::ForStatus(status));
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(const std::string_view& raw_query) const {
     return FindTopDocuments(std::execution::seq, raw_query, DocumentStatus::ACTUAL);
 }
 
+SearchPage SearchServer::FindTopDocuments(const std::string_view& raw_query, DocumentStatus status,
+                                          const PageRequest& page) const {
+    return FindTopDocuments(raw_query, DocumentFilter::ForStatus(status), page);
+}
+
+SearchPage SearchServer::FindTopDocuments(const std::string_view& raw_query, const PageRequest& page) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL, page);
+}
+
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(
+        const std::vector<std::string>& raw_queries) const {
+    std::vector<std::vector<Document>> result(raw_queries.size());
+    // Chunks keep the per-query accumulators in cache and run in parallel
+    std::vector<size_t> chunk_begins;
+    for (size_t begin = 0; begin < raw_queries.size(); begin += BATCH_CHUNK_SIZE) {
+        chunk_begins.push_back(begin);
+    }
+    std::for_each(std::execution::par, chunk_begins.begin(), chunk_begins.end(),
+                  [&](size_t begin) {
+                      const size_t end = std::min(begin + BATCH_CHUNK_SIZE, raw_queries.size());
+                      FindTopDocumentsChunk(raw_queries, begin, end, result);
+                  });
+    return result;
+}
+
+void SearchServer::FindTopDocumentsChunk(const std::vector<std::string>& raw_queries, size_t begin, size_t end,
+                                         std::vector<std::vector<Document>>& result) const {
+    const TfIdfRanking ranking;
+    const RankingContext ranking_context = MakeRankingContext();
+
+    // Plain queries share the scan; others keep their own path
+    std::vector<Query> queries;
+    std::vector<size_t> query_indexes;
+    for (size_t i = begin; i < end; ++i) {
+        Query query = ParseQuery(raw_queries[i]);
+        if (query.expression || !query.phrases.empty() || !query.near_clauses.empty()) {
+            result[i] = FindTopDocuments(raw_queries[i]);
+            continue;
+        }
+        queries.push_back(std::move(query));
+        query_indexes.push_back(i);
+    }
+
+    // Words in the same (sorted) order as plus_words, so every query sums its
+    // contributions in the order FindAllDocuments does and gets equal relevances
+    std::map<std::string_view, std::vector<size_t>> word_to_queries;
+    std::vector<std::vector<int>> excluded_documents(queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        for (const std::string_view& word : queries[i].plus_words) {
+            word_to_queries[word].push_back(i);
+        }
+        excluded_documents[i] = CollectDocumentIds(queries[i].minus_words);
+    }
+
+    // Contributions are appended word by word; a stable sort by id later keeps
+    // the word order of each document's terms, so the sums are bit-identical
+    std::vector<std::vector<std::pair<int, double>>> contributions(queries.size());
+    std::vector<SortedIdCursor> excluded_cursors;
+    for (const auto& [word, word_queries] : word_to_queries) {
+        const auto* word_postings = FindPostings(word);
+        if (word_postings == nullptr) {
+            continue;
+        }
+        const auto& postings = *word_postings;
+        const double word_weight = ranking.ComputeWordWeight(ranking_context, postings.size());
+        excluded_cursors.clear();
+        for (const size_t query_index : word_queries) {
+            excluded_cursors.emplace_back(excluded_documents[query_index]);
+        }
+        // Document data and score are looked up once per posting, not once per query
+        for (const auto [document_id, term_freq] : postings) {
+            const auto& document_data = documents_.at(document_id);
+            if (document_data.status != DocumentStatus::ACTUAL) {
+                continue;
+            }
+            const double score = ranking.ComputeTermScore(
+                    word_weight, term_freq, document_data.word_count, ranking_context);
+            for (size_t i = 0; i < word_queries.size(); ++i) {
+                if (!excluded_cursors[i].Contains(document_id)) {
+                    contributions[word_queries[i]].push_back({document_id, score});
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        auto& query_contributions = contributions[i];
+        std::stable_sort(query_contributions.begin(), query_contributions.end(),
+                         [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+        std::vector<Document>& matched_documents = result[query_indexes[i]];
+        for (auto it = query_contributions.begin(); it != query_contributions.end();) {
+            const int document_id = it->first;
+            double relevance = 0.0;
+            for (; it != query_contributions.end() && it->first == document_id; ++it) {
+                relevance += it->second;
+            }
+            const int rating = documents_.at(document_id).rating;
+            matched_documents.push_back({document_id, ranking.FinalizeScore(relevance, rating), rating});
+        }
+        if (matched_documents.empty() && fuzzy_index_) {
+            matched_documents = FindTopDocuments(raw_queries[query_indexes[i]]);
+            continue;
+        }
+        SelectTopDocuments(matched_documents);
+    }
+}
+
 int SearchServer::GetDocumentCount() const {
     return documents_.size();
 }
@@ -54,6 +267,12 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
         std::vector<std::string_view> out;
         return {out, documents_.at(document_id).status};
     }
+    if (query.expression && !MakeQueryEvaluator().Matches(*query.expression, document_id)) {
+        return {std::vector<std::string_view>{}, documents_.at(document_id).status};
+    }
+    if (!ContainsPhrases(query, document_id)) {
+        return {std::vector<std::string_view>{}, documents_.at(document_id).status};
+    }
 
     auto copy_last_it = std::copy_if(query.plus_words.begin(), query.plus_words.end(),
                                      matched_words.begin(),
@@ -87,6 +306,12 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
         std::vector<std::string_view> out;
         return {out, documents_.at(document_id).status};
     }
+    if (query.expression && !MakeQueryEvaluator().Matches(*query.expression, document_id)) {
+        return {std::vector<std::string_view>{}, documents_.at(document_id).status};
+    }
+    if (!ContainsPhrases(query, document_id)) {
+        return {std::vector<std::string_view>{}, documents_.at(document_id).status};
+    }
 
     auto copy_last_it = std::copy_if(par, query.plus_words.begin(), query.plus_words.end(),
                                      matched_words.begin(),
@@ -100,7 +325,7 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
 }
 
 bool SearchServer::IsStopWord(const std::string_view& word) const {
-    return stop_words_.count(word) > 0;
+    return stop_word_hash_.Find(word) != PerfectHash::NOT_FOUND;
 }
 
 bool SearchServer::IsValidWord(const std::string_view& word) {
@@ -150,17 +375,7 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(const std::string_view& tex
 }
 
 SearchServer::Query SearchServer::ParseQuery(const std::string_view& text) const {
-    Query result;
-    for (const std::string_view& word : SplitIntoWords(text)) {
-        const auto query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                result.minus_words.push_back(query_word.data);
-            } else {
-                result.plus_words.push_back(query_word.data);
-            }
-        }
-    }
+    Query result = ParseQueryWords(text);
     //избавиться от дубликатов плюс и минус слов
     //std::sort--std::unique--std::vector::erase.
     std::sort(result.minus_words.begin(), result.minus_words.end());
@@ -175,30 +390,547 @@ SearchServer::Query SearchServer::ParseQuery(const std::string_view& text) const
 
 SearchServer::Query SearchServer::ParseQuery(const std::execution::parallel_policy& par,
                                              const std::string_view& text) const {
+    return ParseQueryWords(text);
+}
+
+SearchServer::Query SearchServer::ParseQueryWords(const std::string_view& text) const {
+    const std::vector<std::string_view> tokens = SplitIntoWords(text);
+    if (is_boolean_query_enabled_ && HasBooleanOperators(tokens)) {
+        return ParseBooleanQueryWords(tokens);
+    }
     Query result;
-    for (const std::string_view& word : SplitIntoWords(text)) {
+    bool in_phrase = false;
+    int pending_near = 0;  // distance of a NEAR operator waiting for its right operand
+    std::string_view last_plus_word;
+    for (const std::string_view& token : tokens) {
+        std::string_view word = token;
+        bool has_quote = false;
+        // Without the positional index quotes and NEAR are parts of plain words
+        if (positional_index_ && !in_phrase && !word.empty() && word.front() == '"') {
+            word.remove_prefix(1);
+            in_phrase = true;
+            has_quote = true;
+            result.phrases.emplace_back();
+        }
+        if (in_phrase) {
+            const bool closes_phrase = !word.empty() && word.back() == '"';
+            if (closes_phrase) {
+                word.remove_suffix(1);
+                has_quote = true;
+            }
+            if (!word.empty() || !has_quote) {
+                const auto query_word = ParseQueryWord(word);
+                if (query_word.data.find('*') != std::string_view::npos) {
+                    throw std::invalid_argument("Wildcard "s + std::string(word) + " inside a phrase"s);
+                }
+                if (query_word.is_minus) {
+                    throw std::invalid_argument("Minus word "s + std::string(word) + " inside a phrase"s);
+                }
+                if (!query_word.is_stop) {
+                    result.phrases.back().push_back(query_word.data);
+                    result.plus_words.push_back(query_word.data);
+                }
+            }
+            if (closes_phrase) {
+                in_phrase = false;
+                // Phrase of stop words only is ignored as stop words themselves are
+                if (result.phrases.back().empty()) {
+                    result.phrases.pop_back();
+                }
+            }
+            last_plus_word = {};
+            continue;
+        }
+
+        if (const auto near_distance = positional_index_ ? ParseNearOperator(word) : std::nullopt) {
+            if (last_plus_word.empty() || pending_near > 0) {
+                throw std::invalid_argument("NEAR operator must follow a plus word"s);
+            }
+            pending_near = *near_distance;
+            continue;
+        }
+
         const auto query_word = ParseQueryWord(word);
+        if (query_word.data.find('*') != std::string_view::npos) {
+            if (pending_near > 0) {
+                throw std::invalid_argument("NEAR operator must precede a plus word"s);
+            }
+            auto& expanded_words = query_word.is_minus ? result.minus_words : result.plus_words;
+            for (const std::string_view expanded_word : ExpandWildcard(query_word.data)) {
+                expanded_words.push_back(expanded_word);
+            }
+            last_plus_word = {};
+            continue;
+        }
+        if (pending_near > 0) {
+            if (query_word.is_minus || query_word.is_stop) {
+                throw std::invalid_argument("NEAR operator must precede a plus word"s);
+            }
+            result.near_clauses.push_back({last_plus_word, query_word.data, pending_near});
+            pending_near = 0;
+        }
         if (!query_word.is_stop) {
             if (query_word.is_minus) {
                 result.minus_words.push_back(query_word.data);
+                last_plus_word = {};
             } else {
                 result.plus_words.push_back(query_word.data);
+                last_plus_word = query_word.data;
             }
         }
     }
+    if (in_phrase) {
+        throw std::invalid_argument("Phrase is not closed"s);
+    }
+    if (pending_near > 0) {
+        throw std::invalid_argument("NEAR operator must precede a plus word"s);
+    }
     return result;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string_view& word) const {
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+SearchServer::Query SearchServer::ParseBooleanQueryWords(const std::vector<std::string_view>& tokens) const {
+    const auto resolve_word = [this](std::string_view token) {
+        if (positional_index_ && ((!token.empty() && token.front() == '"') || ParseNearOperator(token))) {
+            throw std::invalid_argument("Phrases and NEAR can't be combined with boolean operators"s);
+        }
+        const auto query_word = ParseQueryWord(token);
+        ResolvedQueryWord resolved;
+        resolved.is_minus = query_word.is_minus;
+        if (query_word.is_stop) {
+            return resolved;
+        }
+        QueryNode node;
+        if (query_word.data.find('*') != std::string_view::npos) {
+            // No expansions gives an empty OR, which matches nothing
+            node.type = QueryNode::Type::OR;
+            for (const std::string_view expanded_word : ExpandWildcard(query_word.data)) {
+                QueryNode term;
+                term.term = expanded_word;
+                node.children.push_back(std::move(term));
+            }
+        } else {
+            node.term = query_word.data;
+        }
+        resolved.node = std::move(node);
+        return resolved;
+    };
+
+    Query result;
+    if (auto expression = ParseBooleanQuery(tokens, resolve_word)) {
+        result.plus_words = CollectPositiveTerms(*expression);
+        result.expression = std::make_shared<const QueryNode>(std::move(*expression));
+    }
+    return result;
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    static const std::map<std::string_view, double>& void_map{};
-    if (0 == id_to_word_freqs_.count(document_id)) {
-        return void_map;
+std::optional<int> SearchServer::ParseNearOperator(const std::string_view& text) {
+    static const std::string_view near_operator = "NEAR";
+    if (text.substr(0, near_operator.size()) != near_operator) {
+        return std::nullopt;
+    }
+    std::string_view distance_text = text.substr(near_operator.size());
+    if (distance_text.empty()) {
+        return DEFAULT_NEAR_DISTANCE;
+    }
+    if (distance_text.front() != '/') {
+        return std::nullopt;
     }
-    return id_to_word_freqs_.at(document_id);
+    distance_text.remove_prefix(1);
+    if (distance_text.empty() || distance_text.size() > 6
+        || !std::all_of(distance_text.begin(), distance_text.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        throw std::invalid_argument("Invalid NEAR distance "s + std::string(text));
+    }
+    const int distance = std::stoi(std::string(distance_text));
+    if (distance == 0) {
+        throw std::invalid_argument("Invalid NEAR distance "s + std::string(text));
+    }
+    return distance;
+}
+
+std::vector<std::string_view> SearchServer::ExpandWildcard(const std::string_view& pattern) const {
+    std::vector<std::string_view> result;
+    const std::string_view prefix = pattern.substr(0, pattern.find('*'));
+    if (prefix.empty()) {
+        throw std::invalid_argument("Wildcard "s + std::string(pattern) + " must not start with *"s);
+    }
+    term_dictionary_.ForEachWithPrefix(prefix, [&](std::string_view term, uint32_t term_id) {
+        const auto word_it = dictionary_terms_[term_id];
+        if (!word_it->second.empty() && MatchesWildcard(pattern, term)) {
+            // Query words must outlive the term buffer, so refer to the index keys
+            result.push_back(word_it->first);
+        }
+        return result.size() < MAX_WILDCARD_EXPANSIONS;
+    });
+    return result;
+}
+
+std::vector<int> SearchServer::FindPhraseDocuments(const Query& query) const {
+    std::vector<int> result;
+    for (size_t i = 0; i < query.phrases.size(); ++i) {
+        std::vector<int> phrase_documents = positional_index_->FindPhraseDocuments(query.phrases[i]);
+        if (i == 0) {
+            result = std::move(phrase_documents);
+        } else {
+            std::vector<int> intersection;
+            std::set_intersection(result.begin(), result.end(),
+                                  phrase_documents.begin(), phrase_documents.end(),
+                                  std::back_inserter(intersection));
+            result = std::move(intersection);
+        }
+        if (result.empty()) {
+            break;
+        }
+    }
+    return result;
+}
+
+bool SearchServer::ContainsPhrases(const Query& query, int document_id) const {
+    return std::all_of(query.phrases.begin(), query.phrases.end(),
+                       [&](const std::vector<std::string_view>& phrase) {
+                           return positional_index_->ContainsPhrase(document_id, phrase);
+                       });
+}
+
+double SearchServer::ComputeProximityFactor(const Query& query, int document_id) const {
+    double factor = 1.0;
+    for (const NearClause& clause : query.near_clauses) {
+        if (positional_index_->IsNear(document_id, clause.lhs, clause.rhs, clause.max_distance)) {
+            factor *= PROXIMITY_BOOST;
+        }
+    }
+    return factor;
+}
+
+void SearchServer::EnableBooleanQueries() {
+    is_boolean_query_enabled_ = true;
+}
+
+bool SearchServer::IsBooleanQueryEnabled() const {
+    return is_boolean_query_enabled_;
+}
+
+void SearchServer::EnablePositionalIndex() {
+    if (!documents_.empty()) {
+        throw std::logic_error("Positional index must be enabled before adding documents"s);
+    }
+    positional_index_.emplace();
+}
+
+bool SearchServer::IsPositionalIndexEnabled() const {
+    return positional_index_.has_value();
+}
+
+PositionalIndexStats SearchServer::GetPositionalIndexStats() const {
+    if (!positional_index_) {
+        return {};
+    }
+    return positional_index_->GetStats();
+}
+
+std::vector<std::string> SearchServer::Autocomplete(const std::string_view& prefix, size_t max_count) const {
+    std::vector<std::string> result;
+    if (max_count == 0) {
+        return result;
+    }
+    term_dictionary_.ForEachWithPrefix(prefix, [&](std::string_view term, uint32_t term_id) {
+        // Words of removed documents stay in the dictionary with empty postings
+        if (!dictionary_terms_[term_id]->second.empty()) {
+            result.emplace_back(term);
+        }
+        return result.size() < max_count;
+    });
+    return result;
+}
+
+TermDictionaryStats SearchServer::GetTermDictionaryStats() const {
+    TermDictionaryStats stats = term_dictionary_.GetStats();
+    stats.id_table_bytes = dictionary_terms_.capacity() * sizeof(dictionary_terms_[0]);
+    return stats;
+}
+
+void SearchServer::EnableFuzzySearch(const FuzzySearchOptions& options) {
+    if (options.max_edit_distance < 1 || options.max_edit_distance > 2) {
+        throw std::invalid_argument("Fuzzy search supports edit distance 1 or 2"s);
+    }
+    if (!(options.edit_penalty > 0.0 && options.edit_penalty <= 1.0)) {
+        throw std::invalid_argument("Edit penalty must be in (0, 1]"s);
+    }
+    fuzzy_options_ = options;
+    fuzzy_index_.emplace(options.max_edit_distance);
+    for (const auto& [word, _] : word_to_document_freqs_) {
+        fuzzy_index_->AddTerm(word);
+    }
+}
+
+bool SearchServer::IsFuzzySearchEnabled() const {
+    return fuzzy_index_.has_value();
+}
+
+void SearchServer::EnableImpactOrderedSearch() {
+    if (!impact_index_) {
+        impact_index_.emplace();
+    }
+    impact_index_->Build(word_to_document_freqs_);
+}
+
+void SearchServer::DisableImpactOrderedSearch() {
+    impact_index_.reset();
+}
+
+void SearchServer::EnableDocumentOrdinals() {
+    if (ordinal_index_) {
+        return;
+    }
+    ordinal_index_.emplace();
+    for (const int document_id : document_ids_) {
+        const DocumentData& document_data = documents_.at(document_id);
+        ordinal_index_->AddDocument({document_id, document_data.rating, document_data.status, document_data.word_count},
+                                    GetWordFrequencies(document_id));
+    }
+}
+
+void SearchServer::ReorderDocuments() {
+    EnableDocumentOrdinals();
+    ordinal_index_->Reorder();
+}
+
+DocumentOrderStats SearchServer::GetDocumentOrderStats() const {
+    return ordinal_index_ ? ordinal_index_->GetStats() : DocumentOrderStats{};
+}
+
+MemoryStats SearchServer::GetMemoryStats() const {
+    MemoryStats stats;
+    stats.document_texts = ReadAllocationCounter(memory_counters_->document_texts);
+    stats.inverted_index = ReadAllocationCounter(memory_counters_->inverted_index);
+    stats.forward_index = ReadAllocationCounter(memory_counters_->forward_index);
+    stats.document_data = ReadAllocationCounter(memory_counters_->document_data);
+    stats.document_ids = ReadAllocationCounter(memory_counters_->document_ids);
+    stats.term_count = memory_counters_->term_count.load(std::memory_order_relaxed);
+    stats.posting_count = memory_counters_->posting_count.load(std::memory_order_relaxed);
+    if (stats.term_count > 0) {
+        stats.average_posting_length = static_cast<double>(stats.posting_count) / stats.term_count;
+    }
+    return stats;
+}
+
+void SearchServer::FreezeVocabulary() {
+    std::vector<std::string_view> words;
+    words.reserve(word_to_document_freqs_.size());
+    for (const auto& [word, _] : word_to_document_freqs_) {
+        words.push_back(word);
+    }
+    vocabulary_hash_ = PerfectHash(std::move(words));
+    vocabulary_postings_.resize(vocabulary_hash_.size());
+    for (size_t slot = 0; slot < vocabulary_hash_.size(); ++slot) {
+        vocabulary_postings_[slot] = &word_to_document_freqs_.find(vocabulary_hash_.GetKey(slot))->second;
+    }
+    is_vocabulary_frozen_ = true;
+}
+
+bool SearchServer::IsVocabularyFrozen() const {
+    return is_vocabulary_frozen_;
+}
+
+ImpactSearchStats SearchServer::GetImpactSearchStats(const std::string_view& raw_query) const {
+    ImpactSearchStats stats;
+    FindTopDocumentsByImpact(ParseQuery(raw_query),
+                             [](int /*document_id*/, DocumentStatus status, int /*rating*/) {
+                                 return status == DocumentStatus::ACTUAL;
+                             },
+                             stats);
+    return stats;
+}
+
+const CountedMap<int, double>* SearchServer::FindPostings(std::string_view word) const {
+    if (is_vocabulary_frozen_) {
+        const size_t slot = vocabulary_hash_.Find(word);
+        return slot == PerfectHash::NOT_FOUND ? nullptr : vocabulary_postings_[slot];
+    }
+    const auto word_it = word_to_document_freqs_.find(word);
+    return word_it == word_to_document_freqs_.end() ? nullptr : &word_it->second;
+}
+
+bool SearchServer::HasDocuments(const std::string_view& word) const {
+    const auto* postings = FindPostings(word);
+    return postings != nullptr && !postings->empty();
+}
+
+std::optional<SearchServer::Query> SearchServer::CorrectQuery(const Query& query) const {
+    if (query.expression) {
+        return std::nullopt;
+    }
+    Query result = query;
+    result.plus_words.clear();
+    bool is_corrected = false;
+    for (const std::string_view& word : query.plus_words) {
+        if (HasDocuments(word)) {
+            result.plus_words.push_back(word);
+            continue;
+        }
+        std::vector<std::pair<std::string_view, int>> candidates;
+        int min_distance = fuzzy_options_.max_edit_distance;
+        for (const auto& [candidate, distance] : fuzzy_index_->FindCandidates(word)) {
+            if (!HasDocuments(candidate) || distance > min_distance) {
+                continue;
+            }
+            if (distance < min_distance) {
+                candidates.clear();
+                min_distance = distance;
+            }
+            candidates.push_back({candidate, distance});
+        }
+        for (const auto& [candidate, distance] : candidates) {
+            result.plus_words.push_back(candidate);
+            result.corrected_word_weights.emplace(candidate, std::pow(fuzzy_options_.edit_penalty, distance));
+            is_corrected = true;
+        }
+    }
+    if (!is_corrected) {
+        return std::nullopt;
+    }
+    std::sort(result.plus_words.begin(), result.plus_words.end());
+    result.plus_words.erase(std::unique(result.plus_words.begin(), result.plus_words.end()),
+                            result.plus_words.end());
+    // A word present in the query as typed keeps its full weight
+    for (const std::string_view& word : query.plus_words) {
+        result.corrected_word_weights.erase(word);
+    }
+    return result;
+}
+
+double SearchServer::ComputeCorrectionWeight(const Query& query, const std::string_view& word) {
+    if (query.corrected_word_weights.empty()) {
+        return 1.0;
+    }
+    const auto it = query.corrected_word_weights.find(word);
+    return it == query.corrected_word_weights.end() ? 1.0 : it->second;
+}
+
+BooleanQueryEvaluator SearchServer::MakeQueryEvaluator() const {
+    return BooleanQueryEvaluator(
+            [this](std::string_view word) {
+                return FindPostings(word);
+            },
+            document_ids_);
+}
+
+std::vector<int> SearchServer::CollectDocumentIds(const std::vector<std::string_view>& words) const {
+    std::vector<int> result;
+    for (const std::string_view& word : words) {
+        const auto* postings = FindPostings(word);
+        if (postings == nullptr) {
+            continue;
+        }
+        for (const auto& [document_id, _] : *postings) {
+            result.push_back(document_id);
+        }
+    }
+    if (words.size() > 1) {
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    }
+    return result;
+}
+
+bool SearchServer::IsRankedBefore(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) >= RELEVANCE_EPSILON) {
+        return lhs.relevance > rhs.relevance;
+    }
+    if (lhs.rating != rhs.rating) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.id < rhs.id;
+}
+
+bool SearchServer::IsRankedBeforeExactly(const Document& lhs, const Document& rhs) {
+    if (lhs.relevance != rhs.relevance) {
+        return lhs.relevance > rhs.relevance;
+    }
+    if (lhs.rating != rhs.rating) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.id < rhs.id;
+}
+
+void SearchServer::SelectTopDocuments(std::vector<Document>& matched_documents) {
+    // Ties are broken by id, so any subset holding the top documents gives the same top
+    const size_t top_count = std::min<size_t>(matched_documents.size(), MAX_RESULT_DOCUMENT_COUNT);
+    std::partial_sort(matched_documents.begin(), matched_documents.begin() + top_count, matched_documents.end(),
+                      IsRankedBefore);
+    matched_documents.resize(top_count);
+}
+
+SearchPage SearchServer::SelectPage(std::vector<Document> matched_documents, const std::optional<Document>& boundary,
+                                    size_t offset, size_t limit) {
+    if (boundary) {
+        matched_documents.erase(std::remove_if(matched_documents.begin(), matched_documents.end(),
+                                               [&boundary](const Document& document) {
+                                                   return !IsRankedBeforeExactly(*boundary, document);
+                                               }),
+                                matched_documents.end());
+    }
+    SearchPage page;
+    if (offset >= matched_documents.size()) {
+        return page;
+    }
+    const size_t page_end = offset + std::min(limit, matched_documents.size() - offset);
+    std::partial_sort(matched_documents.begin(), matched_documents.begin() + page_end, matched_documents.end(),
+                      IsRankedBeforeExactly);
+    page.documents.assign(matched_documents.begin() + offset, matched_documents.begin() + page_end);
+    if (page_end < matched_documents.size()) {
+        page.next_cursor = EncodePageCursor(matched_documents[page_end - 1]);
+    }
+    std::sort(page.documents.begin(), page.documents.end(), IsRankedBefore);
+    return page;
+}
+
+std::string SearchServer::EncodePageCursor(const Document& document) {
+    // The relevance is kept bit for bit, so the next page starts exactly after this document
+    uint64_t relevance_bits;
+    std::memcpy(&relevance_bits, &document.relevance, sizeof(relevance_bits));
+    char buffer[16];
+    std::string cursor(buffer, std::to_chars(buffer, buffer + sizeof(buffer), relevance_bits, 16).ptr);
+    cursor += '.';
+    cursor += std::to_string(document.rating);
+    cursor += '.';
+    cursor += std::to_string(document.id);
+    return cursor;
+}
+
+Document SearchServer::DecodePageCursor(const std::string& cursor) {
+    const char* position = cursor.data();
+    const char* const end = cursor.data() + cursor.size();
+    const auto parse = [&position, end](auto& value, int base, bool is_last) {
+        const auto [next, error] = std::from_chars(position, end, value, base);
+        if (error != std::errc() || next == position || (is_last ? next != end : next == end || *next != '.')) {
+            throw std::invalid_argument("Invalid page cursor"s);
+        }
+        position = is_last ? next : next + 1;
+    };
+    uint64_t relevance_bits;
+    Document document;
+    parse(relevance_bits, 16, false);
+    parse(document.rating, 10, false);
+    parse(document.id, 10, true);
+    std::memcpy(&document.relevance, &relevance_bits, sizeof(relevance_bits));
+    return document;
+}
+
+RankingContext SearchServer::MakeRankingContext() const {
+    RankingContext context;
+    context.document_count = GetDocumentCount();
+    if (context.document_count > 0) {
+        context.average_document_length = static_cast<double>(total_word_count_) / context.document_count;
+    }
+    return context;
+}
+
+WordFrequenciesView SearchServer::GetWordFrequencies(int document_id) const {
+    const auto it = documents_.find(document_id);
+    if (it == documents_.end()) {
+        return {};
+    }
+    return {it->second.text, it->second.words};
 }
 
 // Single thread version (implicit)
@@ -210,42 +942,68 @@ void SearchServer::RemoveDocument(const std::execution::sequenced_policy& seq, i
     if (0 == document_ids_.count(document_id)) {
         return;
     }
-    const auto& words_to_freq = GetWordFrequencies(document_id);
-    std::vector<const std::string_view*> document_words(words_to_freq.size());
+    const auto words_to_freq = GetWordFrequencies(document_id);
+    std::vector<std::string_view> document_words(words_to_freq.size());
     std::transform(words_to_freq.begin(), words_to_freq.end(),
                    document_words.begin(),
-                   [&](const auto& word) { return &word.first;});
+                   [&](const auto& word) { return word.first;});
 
     std::for_each(document_words.begin(), document_words.end(),
-                  [&](const auto word) {
-                      if (word_to_document_freqs_.at(*word).count(document_id)) {
-                          word_to_document_freqs_.at(*word).erase(document_id);
+                  [&](const std::string_view word) {
+                      auto& word_postings = word_to_document_freqs_.at(word);
+                      if (word_postings.erase(document_id) > 0 && word_postings.empty()) {
+                          --memory_counters_->term_count;
                       }
                   });
+    if (positional_index_) {
+        positional_index_->RemoveDocument(document_id, words_to_freq);
+    }
+    if (impact_index_) {
+        for (const auto& [word, _] : words_to_freq) {
+            impact_index_->Invalidate(word);
+        }
+    }
+    if (ordinal_index_) {
+        ordinal_index_->RemoveDocument(document_id, words_to_freq);
+    }
+    memory_counters_->posting_count -= words_to_freq.size();
+    total_word_count_ -= documents_.at(document_id).word_count;
     documents_.erase(document_id);
     document_ids_.erase(document_id);
-    id_to_word_freqs_.erase(document_id);
 }
 // Parallel thread version
 void SearchServer::RemoveDocument(const std::execution::parallel_policy& par, int document_id) {
     if (0 == document_ids_.count(document_id)) {
         return;
     }
-    const auto& words_to_freq = GetWordFrequencies(document_id);
-    std::vector<const std::string_view*> document_words(words_to_freq.size());
+    const auto words_to_freq = GetWordFrequencies(document_id);
+    std::vector<std::string_view> document_words(words_to_freq.size());
     std::transform(words_to_freq.begin(), words_to_freq.end(),
                   document_words.begin(),
-                  [&](const auto& word) { return &word.first;});
+                  [&](const auto& word) { return word.first;});
 
     std::for_each(par,
                   document_words.begin(), document_words.end(),
-                  [&](const auto word) {
-        if (word_to_document_freqs_.at(*word).count(document_id)) {
-            word_to_document_freqs_.at(*word).erase(document_id);
+                  [&](const std::string_view word) {
+        auto& word_postings = word_to_document_freqs_.at(word);
+        if (word_postings.erase(document_id) > 0 && word_postings.empty()) {
+            --memory_counters_->term_count;
         }
     });
 
+    if (positional_index_) {
+        positional_index_->RemoveDocument(document_id, words_to_freq);
+    }
+    if (impact_index_) {
+        for (const auto& [word, _] : words_to_freq) {
+            impact_index_->Invalidate(word);
+        }
+    }
+    if (ordinal_index_) {
+        ordinal_index_->RemoveDocument(document_id, words_to_freq);
+    }
+    memory_counters_->posting_count -= words_to_freq.size();
+    total_word_count_ -= documents_.at(document_id).word_count;
     documents_.erase(document_id);
     document_ids_.erase(document_id);
-    id_to_word_freqs_.erase(document_id);
 }
\ No newline at end of file
@@ -15,17 +15,51 @@
 #include <execution>
 #include <future>
 #include <type_traits>
+#include <optional>
+#include <memory>
+#include <unordered_map>
 
 #include "read_input_functions.h"
 #include "document.h"
+#include "document_filter.h"
 #include "string_processing.h"
 #include "log_duration.h"
 #include "concurrent_map.h"
+#include "positional_index.h"
+#include "term_dictionary.h"
+#include "fuzzy_index.h"
+#include "boolean_query.h"
+#include "ranking.h"
+#include "impact_index.h"
+#include "ordinal_index.h"
+#include "memory_stats.h"
+#include "forward_index.h"
+#include "perfect_hash.h"
 
 using namespace std::string_literals;
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 const double RELEVANCE_EPSILON = 1e-6;
+const int DEFAULT_NEAR_DISTANCE = 5;
+const double PROXIMITY_BOOST = 2.0;
+const size_t MAX_WILDCARD_EXPANSIONS = 64;
+const size_t MAX_AUTOCOMPLETE_COUNT = 10;
+const size_t BATCH_CHUNK_SIZE = 256;
+
+// A page of search results: limit documents after skipping offset of them,
+// counted from the start of the ranking or from a cursor of a previous page
+struct PageRequest {
+    size_t offset = 0;
+    size_t limit = MAX_RESULT_DOCUMENT_COUNT;
+    std::string cursor;
+};
+
+struct SearchPage {
+    std::vector<Document> documents;
+    // Opaque position after the last document, for the next PageRequest;
+    // empty if no documents follow
+    std::string next_cursor;
+};
 
 class SearchServer {
 public:
@@ -42,8 +76,23 @@ public:
         SearchServer(SplitIntoWords(stop_words_text));
     }
 
+    // Adds the documents of other again, so the copy owns its texts and
+    // counts its memory from zero; enabled indexes are built anew
+    SearchServer(const SearchServer& other);
+    // Takes the documents and indexes of other, which is left empty with its
+    // stop words and memory counters of its own
+    SearchServer(SearchServer&& other);
+
     void AddDocument(int document_id, const std::string_view& document, DocumentStatus status, const std::vector<int>& ratings);
 
+    // Ranking is TfIdfRanking, Bm25Ranking, RatingBoostedRanking<...> or any type with the same methods.
+    // DocumentPredicate is a DocumentFilter or any callable (int id, DocumentStatus, int rating) -> bool.
+    template <typename DocumentPredicate, typename Policy, typename Ranking>
+    std::vector<Document> FindTopDocuments(const Policy& policy, const Ranking& ranking,
+                                           const std::string_view& raw_query, DocumentPredicate document_predicate) const;
+    template <typename Policy, typename Ranking>
+    std::vector<Document> FindTopDocuments(const Policy& policy, const Ranking& ranking,
+                                           const std::string_view& raw_query, DocumentStatus status) const;
     template <typename DocumentPredicate, typename Policy>
     std::vector<Document> FindTopDocuments(const Policy& policy, const std::string_view& raw_query, DocumentPredicate document_predicate) const;
     template <typename DocumentPredicate>
@@ -55,6 +104,24 @@ public:
     std::vector<Document> FindTopDocuments(const std::string_view& raw_query, DocumentStatus status) const;
     std::vector<Document> FindTopDocuments(const std::string_view& raw_query) const;
 
+    // Pages of the ranking FindTopDocuments would return without its
+    // MAX_RESULT_DOCUMENT_COUNT cap. A cursor page keeps the documents ranked
+    // after the cursor and sorts only as many as it returns; reach deep pages
+    // with cursors rather than large offsets.
+    template <typename DocumentPredicate, typename Policy, typename Ranking>
+    SearchPage FindTopDocuments(const Policy& policy, const Ranking& ranking, const std::string_view& raw_query,
+                                DocumentPredicate document_predicate, const PageRequest& page) const;
+    template <typename DocumentPredicate>
+    SearchPage FindTopDocuments(const std::string_view& raw_query, DocumentPredicate document_predicate,
+                                const PageRequest& page) const;
+    SearchPage FindTopDocuments(const std::string_view& raw_query, DocumentStatus status,
+                                const PageRequest& page) const;
+    SearchPage FindTopDocuments(const std::string_view& raw_query, const PageRequest& page) const;
+
+    // Same results as FindTopDocuments(query) for every query, but postings of a
+    // word shared by several plain queries are scanned once for all of them
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::vector<std::string>& raw_queries) const;
+
     int GetDocumentCount() const;
 
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view& raw_query, int document_id) const;
@@ -71,25 +138,119 @@ public:
         return document_ids_.end();
     }
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    // Distinct words of the document in lexicographic order; empty for unknown ids
+    WordFrequenciesView GetWordFrequencies(int document_id) const;
 
     void RemoveDocument(int document_id);
     void RemoveDocument(const std::execution::sequenced_policy& seq, int document_id);
     void RemoveDocument(const std::execution::parallel_policy& par, int document_id);
 
+    // AND, OR, NOT and parentheses are query operators only when enabled;
+    // otherwise they stay plain query words
+    void EnableBooleanQueries();
+    bool IsBooleanQueryEnabled() const;
+
+    // Word positions are stored only when enabled; must be called before the first AddDocument.
+    // Quoted phrases and NEAR are query operators only with the positional index
+    void EnablePositionalIndex();
+    bool IsPositionalIndexEnabled() const;
+    PositionalIndexStats GetPositionalIndexStats() const;
+
+    // Indexed words starting with prefix, in lexicographic order. Served by a
+    // term dictionary kept in addition to the inverted index, see its stats
+    std::vector<std::string> Autocomplete(const std::string_view& prefix,
+                                          size_t max_count = MAX_AUTOCOMPLETE_COUNT) const;
+    TermDictionaryStats GetTermDictionaryStats() const;
+
+    // Queries without results are retried with unknown plus words replaced by
+    // indexed words within options.max_edit_distance edits
+    void EnableFuzzySearch(const FuzzySearchOptions& options = {});
+    bool IsFuzzySearchEnabled() const;
+
+    // Sequential TF-IDF searches of plain queries then read impact-ordered postings
+    // and stop once the top documents are settled. Lists of words touched by
+    // AddDocument or RemoveDocument are rebuilt by calling this again; until
+    // then queries with those words take the regular path.
+    void EnableImpactOrderedSearch();
+    void DisableImpactOrderedSearch();
+    // Postings read by the impact-ordered search of raw_query among ACTUAL documents
+    ImpactSearchStats GetImpactSearchStats(const std::string_view& raw_query) const;
+
+    // Sequential searches then score over dense internal document ordinals with
+    // flat postings arrays, where a DocumentFilter predicate (also used for
+    // DocumentStatus arguments) skips postings blocks it can't accept;
+    // document ids seen through the API are unchanged. The ordinal postings
+    // are a full second copy of the inverted index (an ordinal and a term
+    // frequency per posting, plus block summaries) that only sequential
+    // searches read, so enabling them roughly doubles the postings memory;
+    // GetDocumentOrderStats reports their size
+    void EnableDocumentOrdinals();
+    // Offline pass renumbering ordinals: documents are grouped by status and
+    // rating, and within a group those sharing words get close ordinals;
+    // enables ordinals if needed
+    void ReorderDocuments();
+    DocumentOrderStats GetDocumentOrderStats() const;
+
+    // Heap bytes of the main structures as counted by their allocators, with
+    // term and posting counts; reads a few atomics, so a monitoring thread
+    // may call it while the server is being updated. Optional indexes (the
+    // positional, fuzzy, impact-ordered and ordinal ones), the term dictionary
+    // and the perfect hashes are not counted; see their own stats where present,
+    // e.g. DocumentOrderStats::array_bytes for the copy of postings by ordinal.
+    MemoryStats GetMemoryStats() const;
+
+    // Builds a perfect hash over the indexed words, so that query words are
+    // looked up with one hash instead of a tree search; adding a document
+    // with a word not indexed yet unfreezes the vocabulary
+    void FreezeVocabulary();
+    bool IsVocabularyFrozen() const;
+
 private:
     struct DocumentData {
         int rating;
         DocumentStatus status;
+        uint32_t word_count;  // non-stop words, for length-normalized rankings
+        std::string_view text;
+        ForwardList words;    // the forward index
     };
 
+    struct MemoryCounters {
+        AllocationCounter document_texts;
+        AllocationCounter inverted_index;
+        AllocationCounter forward_index;
+        AllocationCounter document_data;
+        AllocationCounter document_ids;
+        std::atomic<size_t> term_count{0};
+        std::atomic<size_t> posting_count{0};
+    };
+
+    // On the heap and swapped together with the containers on a move, so that
+    // the allocators of every container keep pointing to live counters
+    std::unique_ptr<MemoryCounters> memory_counters_ = std::make_unique<MemoryCounters>();
     std::string stop_words_text_;
-    std::deque<std::string> all_docs_;
+    std::deque<CountedString, CountingAllocator<CountedString>> all_docs_{
+            CountingAllocator<CountedString>(&memory_counters_->document_texts)};
     const std::set<std::string, std::less<>> stop_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
-    std::set<int> document_ids_;
-    std::map<int, std::map<std::string_view, double>> id_to_word_freqs_;
+    const PerfectHash stop_word_hash_;
+    CountedMap<std::string_view, CountedMap<int, double>> word_to_document_freqs_{
+            CountingAllocator<int>(&memory_counters_->inverted_index)};
+    CountedMap<int, DocumentData> documents_{CountingAllocator<int>(&memory_counters_->document_data)};
+    uint64_t total_word_count_ = 0;
+    CountedSet<int> document_ids_{CountingAllocator<int>(&memory_counters_->document_ids)};
+    bool is_boolean_query_enabled_ = false;
+    std::optional<PositionalIndex> positional_index_;
+    // For prefixes and wildcards only, exact lookups use word_to_document_freqs_
+    TermDictionary term_dictionary_;
+    // Inverted index entries by the term ids of term_dictionary_
+    std::vector<CountedMap<std::string_view, CountedMap<int, double>>::const_iterator> dictionary_terms_;
+    std::optional<FuzzyIndex> fuzzy_index_;
+    std::optional<ImpactOrderedIndex> impact_index_;
+    std::optional<OrdinalIndex> ordinal_index_;
+    FuzzySearchOptions fuzzy_options_;
+    // Set by FreezeVocabulary: postings of every indexed word by its slot
+    bool is_vocabulary_frozen_ = false;
+    PerfectHash vocabulary_hash_;
+    std::vector<const CountedMap<int, double>*> vocabulary_postings_;
 
     bool IsStopWord(const std::string_view& word) const;
 
@@ -107,50 +268,166 @@ private:
 
     QueryWord ParseQueryWord(const std::string_view& text) const;
 
+    // "a NEAR/k b": documents having a and b within k positions get PROXIMITY_BOOST
+    struct NearClause {
+        std::string_view lhs;
+        std::string_view rhs;
+        int max_distance;
+    };
+
     struct Query {
         std::vector<std::string_view> plus_words;
         std::vector<std::string_view> minus_words;
+        // Quoted phrases are required; their words are also scored as plus words
+        std::vector<std::vector<std::string_view>> phrases;
+        std::vector<NearClause> near_clauses;
+        // Relevance multipliers of typo-corrected plus words
+        std::map<std::string_view, double> corrected_word_weights;
+        // Set when the query uses AND, OR, NOT or parentheses; minus words are
+        // then part of the expression and plus_words are its positive terms
+        std::shared_ptr<const QueryNode> expression;
     };
 
     Query ParseQuery(const std::string_view& text) const;
     Query ParseQuery(const std::execution::parallel_policy& par, const std::string_view& text) const;
-
-    // Existence required
-    double ComputeWordInverseDocumentFreq(const std::string_view& word) const;
-
-    template <typename DocumentPredicate, typename Policy>
-    std::vector<Document> FindAllDocuments(const Policy& policy, const Query& query, DocumentPredicate document_predicate) const;
+    Query ParseQueryWords(const std::string_view& text) const;
+    Query ParseBooleanQueryWords(const std::vector<std::string_view>& tokens) const;
+    static std::optional<int> ParseNearOperator(const std::string_view& text);
+    // Indexed words matching a "cat*"-style pattern, at most MAX_WILDCARD_EXPANSIONS of them;
+    // a pattern starting with '*' would scan the whole dictionary and is rejected
+    std::vector<std::string_view> ExpandWildcard(const std::string_view& pattern) const;
+
+    // Sorted ids of documents containing every phrase of the query
+    std::vector<int> FindPhraseDocuments(const Query& query) const;
+    bool ContainsPhrases(const Query& query, int document_id) const;
+    double ComputeProximityFactor(const Query& query, int document_id) const;
+
+    // nullptr for words never indexed
+    const CountedMap<int, double>* FindPostings(std::string_view word) const;
+    bool HasDocuments(const std::string_view& word) const;
+    // Query with unknown plus words replaced by their closest indexed words, if any was found
+    std::optional<Query> CorrectQuery(const Query& query) const;
+    static double ComputeCorrectionWeight(const Query& query, const std::string_view& word);
+
+    BooleanQueryEvaluator MakeQueryEvaluator() const;
+    // Sorted ids of documents containing any of the words
+    std::vector<int> CollectDocumentIds(const std::vector<std::string_view>& words) const;
+
+    RankingContext MakeRankingContext() const;
+
+    // Fills result[begin, end) for FindTopDocumentsBatch
+    void FindTopDocumentsChunk(const std::vector<std::string>& raw_queries, size_t begin, size_t end,
+                               std::vector<std::vector<Document>>& result) const;
+
+    // Order of results: by relevance, then rating, then id
+    static bool IsRankedBefore(const Document& lhs, const Document& rhs);
+    // Same order with relevance compared exactly. Unlike IsRankedBefore it is a strict
+    // weak ordering, so pages cut by it neither skip nor repeat documents
+    static bool IsRankedBeforeExactly(const Document& lhs, const Document& rhs);
+    // Sorts by relevance, then rating, and keeps MAX_RESULT_DOCUMENT_COUNT best
+    static void SelectTopDocuments(std::vector<Document>& matched_documents);
+    // Page of matched_documents ranked exactly after boundary, if set. Pages are cut in
+    // exact order, documents within a page are ordered by IsRankedBefore
+    static SearchPage SelectPage(std::vector<Document> matched_documents, const std::optional<Document>& boundary,
+                                 size_t offset, size_t limit);
+    static std::string EncodePageCursor(const Document& document);
+    // Throws std::invalid_argument for strings not made by EncodePageCursor
+    static Document DecodePageCursor(const std::string& cursor);
+
+    // Top documents of a plain query, same as FindAllDocuments + SelectTopDocuments
+    // with TfIdfRanking; empty if some word has no up-to-date impact list
+    template <typename DocumentPredicate>
+    std::optional<std::vector<Document>> FindTopDocumentsByImpact(const Query& query,
+                                                                  DocumentPredicate document_predicate,
+                                                                  ImpactSearchStats& stats) const;
+
+    // Same as the sequential FindAllDocuments, over ordinal_index_
+    template <typename DocumentPredicate, typename Ranking>
+    std::vector<Document> FindAllDocumentsByOrdinal(const Ranking& ranking, const Query& query,
+                                                    DocumentPredicate document_predicate) const;
+
+    template <typename DocumentPredicate, typename Policy, typename Ranking>
+    std::vector<Document> FindAllDocuments(const Policy& policy, const Ranking& ranking,
+                                           const Query& query, DocumentPredicate document_predicate) const;
 };
 
 template <typename StringContainer>
 SearchServer::SearchServer(const StringContainer& stop_words)
               : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+              , stop_word_hash_(std::vector<std::string_view>(stop_words_.begin(), stop_words_.end()))
 {
     if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
         throw std::invalid_argument("Some of stop words are invalid"s);
     }
 }
 
-template <typename DocumentPredicate, typename Policy>
+template <typename DocumentPredicate, typename Policy, typename Ranking>
 std::vector<Document> SearchServer::FindTopDocuments(const Policy& policy,
+                                                     const Ranking& ranking,
                                                      const std::string_view& raw_query,
                                                      DocumentPredicate document_predicate) const {
     const auto query = ParseQuery(raw_query);
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
-    std::sort(matched_documents.begin(), matched_documents.end(),
-              [](const Document& lhs, const Document& rhs) {
-                  if (std::abs(lhs.relevance - rhs.relevance) < RELEVANCE_EPSILON) {
-                      return lhs.rating > rhs.rating;
-                  } else {
-                      return lhs.relevance > rhs.relevance;
-                  }
-              });
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    if constexpr (std::is_same_v<Ranking, TfIdfRanking>
+                  && std::is_same_v<std::decay_t<Policy>, std::execution::sequenced_policy>) {
+        ImpactSearchStats stats;
+        auto top_documents = FindTopDocumentsByImpact(query, document_predicate, stats);
+        if (top_documents && (!top_documents->empty() || !fuzzy_index_)) {
+            return *top_documents;
+        }
+    }
+    auto matched_documents = FindAllDocuments(policy, ranking, query, document_predicate);
+    if (matched_documents.empty() && fuzzy_index_) {
+        if (const auto corrected_query = CorrectQuery(query)) {
+            matched_documents = FindAllDocuments(policy, ranking, *corrected_query, document_predicate);
+        }
     }
+    SelectTopDocuments(matched_documents);
     return matched_documents;
 }
 
+template <typename DocumentPredicate, typename Policy, typename Ranking>
+SearchPage SearchServer::FindTopDocuments(const Policy& policy,
+                                          const Ranking& ranking,
+                                          const std::string_view& raw_query,
+                                          DocumentPredicate document_predicate,
+                                          const PageRequest& page) const {
+    if (page.limit == 0) {
+        throw std::invalid_argument("Page limit must be positive"s);
+    }
+    const std::optional<Document> boundary =
+            page.cursor.empty() ? std::nullopt : std::optional<Document>(DecodePageCursor(page.cursor));
+    const auto query = ParseQuery(raw_query);
+    auto matched_documents = FindAllDocuments(policy, ranking, query, document_predicate);
+    if (matched_documents.empty() && fuzzy_index_) {
+        if (const auto corrected_query = CorrectQuery(query)) {
+            matched_documents = FindAllDocuments(policy, ranking, *corrected_query, document_predicate);
+        }
+    }
+    return SelectPage(std::move(matched_documents), boundary, page.offset, page.limit);
+}
+
+template <typename DocumentPredicate>
+SearchPage SearchServer::FindTopDocuments(const std::string_view& raw_query,
+                                          DocumentPredicate document_predicate,
+                                          const PageRequest& page) const {
+    return FindTopDocuments(std::execution::seq, TfIdfRanking{}, raw_query, document_predicate, page);
+}
+
+template <typename Policy, typename Ranking>
+std::vector<Document> SearchServer::FindTopDocuments(const Policy& policy,
+                                                     const Ranking& ranking,
+                                                     const std::string_view& raw_query,
+                                                     DocumentStatus status) const {
+    return FindTopDocuments(policy, ranking, raw_query, DocumentFilter::ForStatus(status));
+}
+
+template <typename DocumentPredicate, typename Policy>
+std::vector<Document> SearchServer::FindTopDocuments(const Policy& policy,
+                                                     const std::string_view& raw_query,
+                                                     DocumentPredicate document_predicate) const {
+    return FindTopDocuments(policy, TfIdfRanking{}, raw_query, document_predicate);
+}
+
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(const std::string_view& raw_query,
                                                      DocumentPredicate document_predicate) const {
@@ -165,75 +442,375 @@ template <typename Policy>
 std::vector<Document> SearchServer::FindTopDocuments(const Policy& policy,
                                                      const std::string_view& raw_query,
                                                      DocumentStatus status) const {
-    return FindTopDocuments(policy, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
-    });
+    return FindTopDocuments(policy, raw_query, DocumentFilter::ForStatus(status));
 }
 
-template <typename DocumentPredicate, typename Policy>
+template <typename DocumentPredicate>
+std::optional<std::vector<Document>> SearchServer::FindTopDocumentsByImpact(const Query& query,
+                                                                            DocumentPredicate document_predicate,
+                                                                            ImpactSearchStats& stats) const {
+    if (!impact_index_ || query.expression || !query.phrases.empty() || !query.near_clauses.empty()
+        || !query.corrected_word_weights.empty()) {
+        return std::nullopt;
+    }
+    const TfIdfRanking ranking;
+    const RankingContext ranking_context = MakeRankingContext();
+
+    struct TermCursor {
+        const ImpactList* impacts;
+        double word_weight;
+        size_t block;
+
+        bool IsExhausted() const {
+            return block == impacts->block_max_term_freqs.size();
+        }
+        // Most the term can still add to a document
+        double GetRemainingBound() const {
+            return IsExhausted() ? 0.0 : impacts->block_max_term_freqs[block] * word_weight;
+        }
+    };
+    std::vector<TermCursor> terms;
+    for (const std::string_view& word : query.plus_words) {
+        const auto* postings = FindPostings(word);
+        if (postings == nullptr || postings->empty()) {
+            continue;
+        }
+        const ImpactList* impacts = impact_index_->Find(word);
+        if (impacts == nullptr) {
+            return std::nullopt;
+        }
+        terms.push_back({impacts, ranking.ComputeWordWeight(ranking_context, postings->size()), 0});
+        stats.postings_total += impacts->postings.size();
+    }
+    const std::vector<int> excluded_documents = CollectDocumentIds(query.minus_words);
+
+    // Blocks are read best bound first. Partial scores are lower bounds, and a
+    // document can still gain the bounds of the terms it hasn't been seen in.
+    // Once the K-th partial score beats the sum of all remaining bounds, unseen
+    // documents can't reach the top, and of the seen ones only those whose
+    // bound reaches the K-th partial score need exact scoring.
+    if (terms.size() > 64) {
+        return std::nullopt;
+    }
+    struct Accumulator {
+        double partial = 0.0;
+        uint64_t seen_terms = 0;
+        bool is_accepted = false;
+    };
+    std::unordered_map<int, Accumulator> accumulators;
+    size_t accepted_count = 0;
+    double max_partial = 0.0;
+    size_t next_check = 0;
+    std::vector<double> partials;
+    double kth_partial = 0.0;
+    bool is_settled = false;
+    while (!is_settled) {
+        TermCursor* best_term = nullptr;
+        for (TermCursor& term : terms) {
+            if (!term.IsExhausted()
+                && (best_term == nullptr || term.GetRemainingBound() > best_term->GetRemainingBound())) {
+                best_term = &term;
+            }
+        }
+        if (best_term == nullptr) {
+            break;
+        }
+        const uint64_t term_bit = uint64_t{1} << (best_term - terms.data());
+        const auto& postings = best_term->impacts->postings;
+        const size_t block_end = std::min((best_term->block + 1) * IMPACT_BLOCK_SIZE, postings.size());
+        for (size_t i = best_term->block * IMPACT_BLOCK_SIZE; i < block_end; ++i) {
+            const auto [document_id, term_freq] = postings[i];
+            ++stats.postings_touched;
+            auto [accumulator_it, is_new] = accumulators.try_emplace(document_id);
+            Accumulator& accumulator = accumulator_it->second;
+            if (is_new) {
+                const auto& document_data = documents_.at(document_id);
+                accumulator.is_accepted =
+                        !std::binary_search(excluded_documents.begin(), excluded_documents.end(), document_id)
+                        && document_predicate(document_id, document_data.status, document_data.rating);
+                accepted_count += accumulator.is_accepted ? 1 : 0;
+            }
+            if (accumulator.is_accepted) {
+                accumulator.partial += term_freq * best_term->word_weight;
+                accumulator.seen_terms |= term_bit;
+                max_partial = std::max(max_partial, accumulator.partial);
+            }
+        }
+        ++best_term->block;
+
+        double remaining_bound = 0.0;
+        for (const TermCursor& term : terms) {
+            remaining_bound += term.GetRemainingBound();
+        }
+        // Finding the K-th partial score is linear, so it is redone only after
+        // as many postings as there are accumulators
+        if (accepted_count < MAX_RESULT_DOCUMENT_COUNT || max_partial <= remaining_bound + RELEVANCE_EPSILON
+            || stats.postings_touched < next_check) {
+            continue;
+        }
+        next_check = stats.postings_touched + accumulators.size();
+        partials.clear();
+        for (const auto& [document_id, accumulator] : accumulators) {
+            if (accumulator.is_accepted) {
+                partials.push_back(accumulator.partial);
+            }
+        }
+        const auto kth = partials.begin() + (MAX_RESULT_DOCUMENT_COUNT - 1);
+        std::nth_element(partials.begin(), kth, partials.end(), std::greater<>());
+        kth_partial = *kth;
+        is_settled = kth_partial > remaining_bound + RELEVANCE_EPSILON;
+    }
+
+    std::vector<int> candidate_ids;
+    for (const auto& [document_id, accumulator] : accumulators) {
+        if (!accumulator.is_accepted) {
+            continue;
+        }
+        double bound = accumulator.partial;
+        for (size_t i = 0; is_settled && i < terms.size(); ++i) {
+            if ((accumulator.seen_terms & (uint64_t{1} << i)) == 0) {
+                bound += terms[i].GetRemainingBound();
+            }
+        }
+        if (!is_settled || bound + RELEVANCE_EPSILON >= kth_partial) {
+            candidate_ids.push_back(document_id);
+        }
+    }
+
+    // Exact relevances, summed in the same word order as FindAllDocuments
+    std::vector<std::pair<const CountedMap<int, double>*, double>> weighted_postings;
+    for (const std::string_view& word : query.plus_words) {
+        if (const auto* postings = FindPostings(word)) {
+            weighted_postings.push_back({postings, ranking.ComputeWordWeight(ranking_context, postings->size())});
+        }
+    }
+    std::sort(candidate_ids.begin(), candidate_ids.end());
+    std::vector<Document> matched_documents;
+    matched_documents.reserve(candidate_ids.size());
+    for (const int document_id : candidate_ids) {
+        double relevance = 0.0;
+        for (const auto& [postings, word_weight] : weighted_postings) {
+            const auto posting_it = postings->find(document_id);
+            if (posting_it != postings->end()) {
+                relevance += ranking.ComputeTermScore(word_weight, posting_it->second,
+                                                      documents_.at(document_id).word_count, ranking_context);
+            }
+        }
+        const int rating = documents_.at(document_id).rating;
+        matched_documents.push_back({document_id, ranking.FinalizeScore(relevance, rating), rating});
+    }
+    SelectTopDocuments(matched_documents);
+    return matched_documents;
+}
+
+template <typename DocumentPredicate, typename Ranking>
+std::vector<Document> SearchServer::FindAllDocumentsByOrdinal(const Ranking& ranking, const Query& query,
+                                                              DocumentPredicate document_predicate) const {
+    const RankingContext ranking_context = MakeRankingContext();
+    const auto& documents = ordinal_index_->GetDocuments();
+
+    // The predicate runs once per document; minus words and the boolean
+    // expression mark documents as skipped up front. A DocumentFilter also
+    // skips whole postings blocks by their summaries.
+    enum DocumentState : char {
+        UNSEEN,
+        ACCEPTED,
+        SKIPPED,
+    };
+    std::vector<DocumentState> states(documents.size(), UNSEEN);
+    std::vector<double> relevances(documents.size(), 0.0);
+    std::vector<uint32_t> accepted_ordinals;
+    const auto check_document = [&](uint32_t ordinal) {
+        const OrdinalDocument& document = documents[ordinal];
+        // Postings of removed documents stay until the index is compacted
+        states[ordinal] = document.id != OrdinalDocument::REMOVED_ID
+                                  && document_predicate(document.id, document.status, document.rating)
+                          ? ACCEPTED
+                          : SKIPPED;
+        if (states[ordinal] == ACCEPTED) {
+            accepted_ordinals.push_back(ordinal);
+        }
+    };
+    if (query.expression) {
+        std::fill(states.begin(), states.end(), SKIPPED);
+        for (const int document_id : MakeQueryEvaluator().Evaluate(*query.expression)) {
+            check_document(*ordinal_index_->FindOrdinal(document_id));
+        }
+    } else {
+        for (const std::string_view& word : query.minus_words) {
+            if (const OrdinalPostings* postings = ordinal_index_->Find(word)) {
+                for (const uint32_t ordinal : postings->ordinals) {
+                    states[ordinal] = SKIPPED;
+                }
+            }
+        }
+    }
+
+    for (const std::string_view& word : query.plus_words) {
+        const OrdinalPostings* postings = ordinal_index_->Find(word);
+        // Ordinals may still include removed documents, the inverted index holds the live frequency
+        const auto* live_postings = FindPostings(word);
+        if (postings == nullptr || live_postings == nullptr || live_postings->empty()) {
+            continue;
+        }
+        const double word_weight = ranking.ComputeWordWeight(ranking_context, live_postings->size())
+                                   * ComputeCorrectionWeight(query, word);
+        for (size_t block = 0; block < postings->blocks.size(); ++block) {
+            if constexpr (std::is_same_v<DocumentPredicate, DocumentFilter>) {
+                const PostingsBlockSummary& summary = postings->blocks[block];
+                if (!document_predicate.MayAccept(summary.status_mask, summary.min_rating, summary.max_rating)) {
+                    continue;
+                }
+            }
+            const size_t end = std::min((block + 1) * ORDINAL_BLOCK_SIZE, postings->ordinals.size());
+            for (size_t i = block * ORDINAL_BLOCK_SIZE; i < end; ++i) {
+                const uint32_t ordinal = postings->ordinals[i];
+                if (states[ordinal] == UNSEEN) {
+                    check_document(ordinal);
+                }
+                if (states[ordinal] == ACCEPTED) {
+                    relevances[ordinal] += ranking.ComputeTermScore(word_weight, postings->term_freqs[i],
+                                                                    documents[ordinal].word_count, ranking_context);
+                }
+            }
+        }
+    }
+
+    // Back to id order, which ties between equal documents follow
+    std::vector<std::pair<int, double>> document_relevances;
+    document_relevances.reserve(accepted_ordinals.size());
+    for (const uint32_t ordinal : accepted_ordinals) {
+        document_relevances.push_back({documents[ordinal].id, relevances[ordinal]});
+    }
+    std::sort(document_relevances.begin(), document_relevances.end());
+
+    const std::vector<int> phrase_documents = FindPhraseDocuments(query);
+    std::vector<Document> matched_documents;
+    matched_documents.reserve(document_relevances.size());
+    for (const auto& [document_id, relevance] : document_relevances) {
+        if (!query.phrases.empty()
+            && !std::binary_search(phrase_documents.begin(), phrase_documents.end(), document_id)) {
+            continue;
+        }
+        const int rating = documents_.at(document_id).rating;
+        matched_documents.push_back(
+                {document_id, ranking.FinalizeScore(relevance * ComputeProximityFactor(query, document_id), rating),
+                 rating});
+    }
+    return matched_documents;
+}
+
+template <typename DocumentPredicate, typename Policy, typename Ranking>
 std::vector<Document> SearchServer::FindAllDocuments(const Policy& policy,
+                                                     const Ranking& ranking,
                                                      const Query& query,
                                                      DocumentPredicate document_predicate) const {
+    if constexpr (!std::is_same_v<std::decay_t<Policy>, std::execution::parallel_policy>) {
+        if (ordinal_index_) {
+            return FindAllDocumentsByOrdinal(ranking, query, document_predicate);
+        }
+    }
     std::vector<Document> matched_documents;
+    const RankingContext ranking_context = MakeRankingContext();
+
+    // Minus words and boolean expressions are applied while scanning the postings:
+    // postings come in ascending id order, so each check gallops forward over a sorted id list
+    const std::vector<int> excluded_documents = CollectDocumentIds(query.minus_words);
+    const std::vector<int> candidate_documents =
+            query.expression ? MakeQueryEvaluator().Evaluate(*query.expression) : std::vector<int>{};
+    const auto make_skip_check = [&]() {
+        return [&query,
+                excluded = SortedIdCursor(excluded_documents),
+                candidates = SortedIdCursor(candidate_documents)](int document_id) mutable {
+            return query.expression ? !candidates.Contains(document_id) : excluded.Contains(document_id);
+        };
+    };
 
     if constexpr (std::is_same_v<std::decay_t<Policy>, std::execution::parallel_policy>) {
 
         static constexpr int NUM_THREADS = 16;
         ConcurrentMap<int, double> document_to_relevance(NUM_THREADS);
 
+        // Boolean matches keep their place even without scored words, e.g. "a OR NOT b"
+        std::for_each(policy, candidate_documents.begin(), candidate_documents.end(),
+                      [&](int document_id) {
+                          const auto& document_data = documents_.at(document_id);
+                          if (document_predicate(document_id, document_data.status, document_data.rating)) {
+                              document_to_relevance[document_id];
+                          }
+        });
+
         std::for_each(policy, query.plus_words.begin(), query.plus_words.end(),
                       [&](const std::string_view& it) {
-                          if (word_to_document_freqs_.count(it) != 0) {
-                             const double inverse_document_freq = ComputeWordInverseDocumentFreq(it);
-                             for (const auto& [document_id, term_freq] : word_to_document_freqs_.at(it)) {
+                          if (const auto* word_postings = FindPostings(it)) {
+                             const auto& postings = *word_postings;
+                             const double word_weight = ranking.ComputeWordWeight(ranking_context, postings.size())
+                                                        * ComputeCorrectionWeight(query, it);
+                             auto is_skipped = make_skip_check();
+                             for (const auto& [document_id, term_freq] : postings) {
+                                 if (is_skipped(document_id)) {
+                                     continue;
+                                 }
                                  const auto& document_data = documents_.at(document_id);
                                  if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                                     document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
+                                     document_to_relevance[document_id].ref_to_value += ranking.ComputeTermScore(
+                                             word_weight, term_freq, document_data.word_count, ranking_context);
                                  }
                              }
                           }
         });
 
-        for (const std::string_view& word : query.minus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
-            }
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                document_to_relevance.erase(document_id);
-            }
-        }
+        const std::vector<int> phrase_documents = FindPhraseDocuments(query);
         matched_documents.reserve(document_to_relevance.size());
         for (const auto [document_id, relevance] : document_to_relevance.BuildOrdinaryMap()) {
+            if (!query.phrases.empty()
+                && !std::binary_search(phrase_documents.begin(), phrase_documents.end(), document_id)) {
+                continue;
+            }
+            const int rating = documents_.at(document_id).rating;
             matched_documents.push_back(
-                    {document_id, relevance, documents_.at(document_id).rating});
+                    {document_id, ranking.FinalizeScore(relevance * ComputeProximityFactor(query, document_id), rating),
+                     rating});
         }
     } else {
-
         std::map<int, double> document_to_relevance;
+        for (const int document_id : candidate_documents) {
+            const auto& document_data = documents_.at(document_id);
+            if (document_predicate(document_id, document_data.status, document_data.rating)) {
+                document_to_relevance.emplace_hint(document_to_relevance.end(), document_id, 0.0);
+            }
+        }
         for (const std::string_view& word : query.plus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
+            const auto* word_postings = FindPostings(word);
+            if (word_postings == nullptr) {
                 continue;
             }
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
+            const auto& postings = *word_postings;
+            const double word_weight = ranking.ComputeWordWeight(ranking_context, postings.size())
+                                       * ComputeCorrectionWeight(query, word);
+            auto is_skipped = make_skip_check();
+            for (const auto [document_id, term_freq] : postings) {
+                if (is_skipped(document_id)) {
+                    continue;
+                }
                 const auto& document_data = documents_.at(document_id);
                 if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
+                    document_to_relevance[document_id] += ranking.ComputeTermScore(
+                            word_weight, term_freq, document_data.word_count, ranking_context);
                 }
             }
         }
-        for (const std::string_view& word : query.minus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
-            }
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                document_to_relevance.erase(document_id);
-            }
-        }
+        const std::vector<int> phrase_documents = FindPhraseDocuments(query);
         matched_documents.reserve(document_to_relevance.size());
         for (const auto [document_id, relevance] : document_to_relevance) {
+            if (!query.phrases.empty()
+                && !std::binary_search(phrase_documents.begin(), phrase_documents.end(), document_id)) {
+                continue;
+            }
+            const int rating = documents_.at(document_id).rating;
             matched_documents.push_back(
-                    {document_id, relevance, documents_.at(document_id).rating});
+                    {document_id, ranking.FinalizeScore(relevance * ComputeProximityFactor(query, document_id), rating),
+                     rating});
         }
     }
     return matched_documents;
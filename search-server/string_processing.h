@@ -8,10 +8,14 @@ std::vector<std::string_view> SplitIntoWords(const std::string_view& text);
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
     std::set<std::string, std::less<>> non_empty_strings;
-    for (const std::string_view& str : strings) {
-        if (!str.empty()) {
-            non_empty_strings.insert(std::string(str));
+    for (const auto& str : strings) {
+        const std::string_view word = str;
+        if (!word.empty()) {
+            non_empty_strings.insert(std::string(word));
         }
     }
     return non_empty_strings;
-}
\ No newline at end of file
+}
+
+// Glob-style match where '*' stands for any (possibly empty) sequence of characters
+bool MatchesWildcard(std::string_view pattern, std::string_view text);
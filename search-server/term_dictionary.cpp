@@ -0,0 +1,185 @@
+#include "term_dictionary.h"
+
+#include <algorithm>
+#include <iterator>
+
+void TermDictionary::Insert(std::string_view term, uint32_t term_id) {
+    if (Contains(term)) {
+        return;
+    }
+    pending_.emplace(std::string(term), term_id);
+    if (pending_.size() >= std::max(MIN_PENDING_TERMS, frozen_count_ / 8)) {
+        Freeze();
+    }
+}
+
+bool TermDictionary::Contains(std::string_view term) const {
+    if (pending_.count(term) > 0) {
+        return true;
+    }
+    const Cursor cursor = LowerBound(term);
+    return cursor.IsValid() && cursor.Term() == term;
+}
+
+void TermDictionary::Freeze() {
+    if (pending_.empty()) {
+        return;
+    }
+    std::vector<std::pair<std::string, uint32_t>> frozen_terms;
+    frozen_terms.reserve(frozen_count_);
+    for (Cursor cursor(*this, 0); cursor.IsValid(); cursor.Next()) {
+        frozen_terms.emplace_back(cursor.Term(), cursor.TermId());
+    }
+    std::vector<std::pair<std::string, uint32_t>> terms;
+    terms.reserve(frozen_terms.size() + pending_.size());
+    std::merge(std::make_move_iterator(frozen_terms.begin()), std::make_move_iterator(frozen_terms.end()),
+               pending_.begin(), pending_.end(),
+               std::back_inserter(terms),
+               [](const auto& lhs, const auto& rhs) {
+                   return lhs.first < rhs.first;
+               });
+    pending_.clear();
+
+    data_.clear();
+    block_offsets_.clear();
+    std::string_view previous;
+    for (size_t i = 0; i < terms.size(); ++i) {
+        const std::string_view term = terms[i].first;
+        if (i % BLOCK_SIZE == 0) {
+            block_offsets_.push_back(static_cast<uint32_t>(data_.size()));
+            WriteVarint(data_, static_cast<uint32_t>(term.size()));
+            data_.insert(data_.end(), term.begin(), term.end());
+        } else {
+            const auto mismatch = std::mismatch(previous.begin(), previous.end(), term.begin(), term.end());
+            const size_t shared = std::distance(previous.begin(), mismatch.first);
+            WriteVarint(data_, static_cast<uint32_t>(shared));
+            WriteVarint(data_, static_cast<uint32_t>(term.size() - shared));
+            data_.insert(data_.end(), term.begin() + shared, term.end());
+        }
+        WriteVarint(data_, terms[i].second);
+        previous = term;
+    }
+    data_.shrink_to_fit();
+    block_offsets_.shrink_to_fit();
+    frozen_count_ = terms.size();
+}
+
+size_t TermDictionary::size() const {
+    return frozen_count_ + pending_.size();
+}
+
+TermDictionaryStats TermDictionary::GetStats() const {
+    // Rough per-node cost of a std::map node: three pointers and a color word
+    static constexpr size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+
+    TermDictionaryStats stats;
+    stats.term_count = size();
+    stats.frozen_bytes = data_.capacity() + block_offsets_.capacity() * sizeof(uint32_t);
+    for (const auto& [term, term_id] : pending_) {
+        stats.pending_bytes += MAP_NODE_OVERHEAD + sizeof(term) + sizeof(term_id)
+                               + (term.capacity() > 15 ? term.capacity() + 1 : 0);
+    }
+    return stats;
+}
+
+TermDictionary::Cursor TermDictionary::LowerBound(std::string_view term) const {
+    // Last block whose head is not greater than term
+    size_t left = 0;
+    size_t right = block_offsets_.size();
+    while (left < right) {
+        const size_t middle = left + (right - left) / 2;
+        if (BlockHead(middle) <= term) {
+            left = middle + 1;
+        } else {
+            right = middle;
+        }
+    }
+    Cursor cursor(*this, left == 0 ? 0 : left - 1);
+    while (cursor.IsValid() && cursor.Term() < term) {
+        cursor.Next();
+    }
+    return cursor;
+}
+
+std::string_view TermDictionary::BlockHead(size_t block) const {
+    size_t offset = block_offsets_[block];
+    const uint32_t length = ReadVarint(data_, offset);
+    return {data_.data() + offset, length};
+}
+
+void TermDictionary::WriteVarint(std::vector<char>& data, uint32_t value) {
+    while (value >= 0x80) {
+        data.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<char>(value));
+}
+
+uint32_t TermDictionary::ReadVarint(const std::vector<char>& data, size_t& offset) {
+    uint32_t value = 0;
+    int shift = 0;
+    while (true) {
+        const auto byte = static_cast<uint8_t>(data[offset++]);
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+        shift += 7;
+    }
+}
+
+TermDictionary::Cursor::Cursor(const TermDictionary& dictionary, size_t block)
+        : dictionary_(dictionary)
+        , block_(block)
+        , offset_(0)
+        , index_in_block_(0)
+        , valid_(block < dictionary.block_offsets_.size()) {
+    if (valid_) {
+        offset_ = dictionary_.block_offsets_[block_];
+        ReadTerm();
+    }
+}
+
+bool TermDictionary::Cursor::IsValid() const {
+    return valid_;
+}
+
+const std::string& TermDictionary::Cursor::Term() const {
+    return term_;
+}
+
+uint32_t TermDictionary::Cursor::TermId() const {
+    return term_id_;
+}
+
+void TermDictionary::Cursor::Next() {
+    const auto& offsets = dictionary_.block_offsets_;
+    const size_t block_end = block_ + 1 < offsets.size() ? offsets[block_ + 1] : dictionary_.data_.size();
+    ++index_in_block_;
+    if (offset_ >= block_end) {
+        ++block_;
+        if (block_ >= offsets.size()) {
+            valid_ = false;
+            return;
+        }
+        offset_ = offsets[block_];
+        index_in_block_ = 0;
+    }
+    ReadTerm();
+}
+
+void TermDictionary::Cursor::ReadTerm() {
+    const auto& data = dictionary_.data_;
+    if (index_in_block_ == 0) {
+        const uint32_t length = ReadVarint(data, offset_);
+        term_.assign(data.data() + offset_, length);
+        offset_ += length;
+    } else {
+        const uint32_t shared = ReadVarint(data, offset_);
+        const uint32_t suffix = ReadVarint(data, offset_);
+        term_.resize(shared);
+        term_.append(data.data() + offset_, suffix);
+        offset_ += suffix;
+    }
+    term_id_ = ReadVarint(data, offset_);
+}
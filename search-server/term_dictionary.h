@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct TermDictionaryStats {
+    size_t term_count = 0;
+    size_t frozen_bytes = 0;   // front-coded blocks and block offsets
+    size_t pending_bytes = 0;  // estimate for terms not merged into blocks yet
+    size_t id_table_bytes = 0; // the owner's table from term ids to its own data, if any
+};
+
+// Sorted term dictionary stored as front-coded blocks: the first term of every
+// block is kept whole, the rest as (shared prefix length, suffix). Exact lookup
+// is a binary search over block heads plus a short scan inside one block.
+// New terms go to a small sorted buffer that is merged in when it grows.
+// Every term is stored with an id given by the caller, so that enumeration
+// leads straight to data the caller keeps by id instead of a second lookup.
+// SearchServer keeps it next to its inverted index for prefix and wildcard
+// enumeration only; exact word lookups still go through the index map, so the
+// dictionary costs memory on top of the map keys rather than saving any.
+class TermDictionary {
+public:
+    // A term already present keeps its first id
+    void Insert(std::string_view term, uint32_t term_id);
+
+    bool Contains(std::string_view term) const;
+
+    // Calls callback(term, term_id) in lexicographic order for terms starting
+    // with prefix until callback returns false
+    template <typename Callback>
+    void ForEachWithPrefix(std::string_view prefix, Callback callback) const;
+
+    // Moves all buffered terms into the front-coded blocks
+    void Freeze();
+
+    size_t size() const;
+
+    TermDictionaryStats GetStats() const;
+
+private:
+    static constexpr size_t BLOCK_SIZE = 16;
+    static constexpr size_t MIN_PENDING_TERMS = 256;
+
+    // Sequential decoder over front-coded blocks
+    class Cursor {
+    public:
+        Cursor(const TermDictionary& dictionary, size_t block);
+
+        bool IsValid() const;
+        const std::string& Term() const;
+        uint32_t TermId() const;
+        void Next();
+
+    private:
+        const TermDictionary& dictionary_;
+        size_t block_;
+        size_t offset_;
+        size_t index_in_block_;
+        std::string term_;
+        uint32_t term_id_ = 0;
+        bool valid_;
+
+        void ReadTerm();
+    };
+
+    std::vector<char> data_;
+    std::vector<uint32_t> block_offsets_;
+    size_t frozen_count_ = 0;
+    std::map<std::string, uint32_t, std::less<>> pending_;
+
+    Cursor LowerBound(std::string_view term) const;
+    std::string_view BlockHead(size_t block) const;
+
+    static void WriteVarint(std::vector<char>& data, uint32_t value);
+    static uint32_t ReadVarint(const std::vector<char>& data, size_t& offset);
+};
+
+template <typename Callback>
+void TermDictionary::ForEachWithPrefix(std::string_view prefix, Callback callback) const {
+    const auto has_prefix = [prefix](std::string_view term) {
+        return term.substr(0, prefix.size()) == prefix;
+    };
+    Cursor frozen = LowerBound(prefix);
+    auto pending_it = pending_.lower_bound(prefix);
+    // Merge the two sorted sources; the sets never share a term
+    while (true) {
+        const bool frozen_ok = frozen.IsValid() && has_prefix(frozen.Term());
+        const bool pending_ok = pending_it != pending_.end() && has_prefix(pending_it->first);
+        if (!frozen_ok && !pending_ok) {
+            return;
+        }
+        if (frozen_ok && (!pending_ok || frozen.Term() < pending_it->first)) {
+            if (!callback(std::string_view(frozen.Term()), frozen.TermId())) {
+                return;
+            }
+            frozen.Next();
+        } else {
+            if (!callback(std::string_view(pending_it->first), pending_it->second)) {
+                return;
+            }
+            ++pending_it;
+        }
+    }
+}
@@ -0,0 +1,274 @@
+#include "tests.h"
+
+#include <algorithm>
+#include <chrono>
+#include <execution>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "request_queue.h"
+#include "search_server.h"
+
+using namespace std::string_literals;
+
+static void Check(bool condition, const std::string& message) {
+    if (!condition) {
+        throw std::logic_error("Test failed: "s + message);
+    }
+}
+
+void TestMovedServerKeepsStopWords() {
+    std::optional<SearchServer> source;
+    source.emplace("and with"s);
+    source->AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, {1});
+    SearchServer search_server = std::move(*source);
+    source.reset();
+    Check(search_server.FindTopDocuments("cat and"s).size() == 1, "moved server finds its document"s);
+    Check(search_server.FindTopDocuments("and with"s).empty(), "moved server still skips stop words"s);
+}
+
+void TestMovedServerKeepsFrozenVocabulary() {
+    std::optional<SearchServer> source;
+    source.emplace("and"s);
+    source->AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, {1});
+    source->AddDocument(2, "dog and bird"s, DocumentStatus::ACTUAL, {2});
+    source->FreezeVocabulary();
+    SearchServer search_server = std::move(*source);
+    source.reset();
+    Check(search_server.IsVocabularyFrozen(), "vocabulary stays frozen after a move"s);
+    Check(search_server.FindTopDocuments("dog"s).size() == 2, "frozen vocabulary finds moved postings"s);
+    Check(search_server.FindTopDocuments("bird"s).front().id == 2, "frozen vocabulary maps words to their postings"s);
+    Check(search_server.FindTopDocuments("fish"s).empty(), "unknown words have no postings"s);
+    Check(search_server.Autocomplete("bi"s) == std::vector<std::string>{"bird"s}, "moved dictionary finds its terms"s);
+}
+
+void TestMoveSourceOutlivesTarget() {
+    SearchServer source("and"s);
+    source.EnablePositionalIndex();
+    source.AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, {1});
+    {
+        std::optional<SearchServer> target;
+        target.emplace(std::move(source));
+        Check(target->FindTopDocuments("\"cat dog\""s).size() == 1, "move target takes the documents"s);
+        Check(target->GetMemoryStats().posting_count == 2, "move target takes the memory counters"s);
+    }
+    Check(source.GetDocumentCount() == 0 && source.GetMemoryStats().posting_count == 0,
+          "move source is left empty"s);
+    source.AddDocument(2, "cat and bird"s, DocumentStatus::ACTUAL, {2});
+    Check(source.FindTopDocuments("cat"s).size() == 1, "move source stays usable"s);
+    Check(source.GetMemoryStats().posting_count == 2, "move source counts its own memory"s);
+}
+
+void TestCopiedServerIsIndependent() {
+    std::optional<SearchServer> source;
+    source.emplace("and"s);
+    source->EnablePositionalIndex();
+    source->AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, {1, 2, 6});
+    source->AddDocument(2, "dog and bird"s, DocumentStatus::BANNED, {2});
+    source->FreezeVocabulary();
+    SearchServer search_server(*source);
+    const auto expected = source->FindTopDocuments("dog"s);
+    source->RemoveDocument(1);
+    source.reset();
+
+    const auto documents = search_server.FindTopDocuments("dog"s);
+    Check(documents.size() == 1 && documents[0].id == 1 && documents[0].rating == 3
+          && documents[0].relevance == expected[0].relevance, "copy keeps documents and ratings"s);
+    Check(search_server.FindTopDocuments("bird"s, DocumentStatus::BANNED).size() == 1, "copy keeps statuses"s);
+    Check(search_server.FindTopDocuments("\"cat dog\""s).size() == 1, "copy keeps the positional index"s);
+    Check(search_server.IsVocabularyFrozen(), "copy keeps the vocabulary frozen"s);
+    Check(search_server.GetMemoryStats().posting_count == 4, "copy counts its own postings"s);
+}
+
+void TestPhraseSyntaxNeedsPositionalIndex() {
+    SearchServer plain_server("and"s);
+    plain_server.AddDocument(1, "say \"hello NEAR me"s, DocumentStatus::ACTUAL, {1});
+    Check(plain_server.FindTopDocuments("\"hello"s).size() == 1, "quotes are plain by default"s);
+    Check(plain_server.FindTopDocuments("NEAR"s).size() == 1, "NEAR is plain by default"s);
+
+    SearchServer search_server("and"s);
+    search_server.EnablePositionalIndex();
+    search_server.AddDocument(1, "cat and dog bird"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "dog cat bird"s, DocumentStatus::ACTUAL, {2});
+    search_server.AddDocument(3, "cat dog"s, DocumentStatus::ACTUAL, {3});
+    const auto documents = search_server.FindTopDocuments("\"cat dog\""s);
+    Check(documents.size() == 2 && documents[0].id != 2 && documents[1].id != 2,
+          "phrases skip stop words and keep word order"s);
+    Check(search_server.FindTopDocuments("\"cat dog bird\""s).size() == 1, "every phrase word must be present"s);
+}
+
+void TestWildcardsAndAutocomplete() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "cat and catfish"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cattle"s, DocumentStatus::ACTUAL, {2});
+    Check(search_server.FindTopDocuments("cat*"s).size() == 2, "wildcard expands through the dictionary"s);
+    search_server.RemoveDocument(2);
+    Check(search_server.Autocomplete("cat"s) == std::vector<std::string>{"cat"s, "catfish"s},
+          "autocomplete skips words of removed documents"s);
+    bool is_rejected = false;
+    try {
+        search_server.FindTopDocuments("*fish"s);
+    } catch (const std::invalid_argument&) {
+        is_rejected = true;
+    }
+    Check(is_rejected, "wildcards starting with * are rejected"s);
+}
+
+void TestOrdinalSearchSkipsRemovedDocuments() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "dog and bird"s, DocumentStatus::ACTUAL, {2});
+    search_server.AddDocument(3, "bird"s, DocumentStatus::ACTUAL, {3});
+    search_server.EnableDocumentOrdinals();
+    search_server.RemoveDocument(1);
+    SearchServer plain_server("and"s);
+    plain_server.AddDocument(2, "dog and bird"s, DocumentStatus::ACTUAL, {2});
+    plain_server.AddDocument(3, "bird"s, DocumentStatus::ACTUAL, {3});
+
+    const auto documents = search_server.FindTopDocuments("cat dog bird"s);
+    const auto expected = plain_server.FindTopDocuments("cat dog bird"s);
+    Check(documents.size() == 2, "removed document is not found through ordinals"s);
+    Check(documents[0].id == expected[0].id && documents[0].relevance == expected[0].relevance,
+          "removed documents don't count in word weights"s);
+    const DocumentOrderStats order_stats = search_server.GetDocumentOrderStats();
+    Check(order_stats.array_bytes >= order_stats.posting_count * (sizeof(uint32_t) + sizeof(double)),
+          "ordinal stats count the memory of their copy of the postings"s);
+}
+
+void TestBooleanQueriesAreOptIn() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "cat OR dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "(cat) and bird"s, DocumentStatus::ACTUAL, {2});
+    Check(search_server.FindTopDocuments("OR"s).size() == 1, "OR is a plain word by default"s);
+    Check(search_server.FindTopDocuments("(cat)"s).size() == 1, "parentheses are plain by default"s);
+
+    search_server.EnableBooleanQueries();
+    Check(search_server.FindTopDocuments("cat AND NOT bird"s).size() == 1, "enabled operators are parsed"s);
+    std::string message;
+    try {
+        search_server.FindTopDocuments("OR cat"s);
+    } catch (const std::invalid_argument& e) {
+        message = e.what();
+    }
+    Check(message == "Missing operand before OR"s, "leading OR reports its missing operand"s);
+}
+
+void TestBooleanQueriesKeepMinusWords() {
+    SearchServer search_server("and"s);
+    search_server.EnableBooleanQueries();
+    int document_id = 0;
+    for (const std::string& text : {"a c"s, "a b c"s, "a"s, "ba"s, "ab cadb"s, "ab cadb adac"s, "ab"s,
+                                     "ba dca"s, "daa"s, "daa dca"s}) {
+        search_server.AddDocument(++document_id, text, DocumentStatus::ACTUAL, {1});
+    }
+    const auto find_ids = [&search_server](const std::string& raw_query) {
+        std::vector<int> ids;
+        for (const Document& document : search_server.FindTopDocuments(raw_query)) {
+            ids.push_back(document.id);
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    };
+    Check(find_ids("a -b AND c"s) == std::vector<int>{1}, "minus word before AND excludes from the group"s);
+    Check(find_ids("ba ab -adac AND cadb"s) == std::vector<int>{4, 5, 8}, "AND binds the plus words around a minus word"s);
+    Check(find_ids("ba -dca AND dca daa"s) == std::vector<int>{9}, "minus word excludes every alternative"s);
+    Check(find_ids("a -b OR c"s) == std::vector<int>{1, 3}, "minus word before OR excludes from the group"s);
+    Check(find_ids("a AND -b"s) == std::vector<int>{1, 3}, "minus word after AND is still its operand"s);
+}
+
+void TestRequestQueueCountsConcurrentRequests() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, {1});
+    constexpr int THREAD_COUNT = 4;
+    constexpr int REQUEST_COUNT = 500;
+
+    RequestQueue request_queue(search_server);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < THREAD_COUNT; ++i) {
+        threads.emplace_back([&request_queue] {
+            for (int j = 0; j < REQUEST_COUNT; ++j) {
+                request_queue.AddFindRequest(j % 2 == 0 ? "cat"s : "bird"s);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const RequestStats stats = request_queue.GetStats();
+    Check(stats.request_count == THREAD_COUNT * REQUEST_COUNT, "no concurrent request is lost"s);
+    Check(stats.no_result_count == THREAD_COUNT * REQUEST_COUNT / 2, "no concurrent empty result is lost"s);
+
+    // Many laps over the ring of buckets, then one window of quiet
+    using namespace std::chrono_literals;
+    RequestQueue short_queue(search_server, 200ms);
+    threads.clear();
+    for (int i = 0; i < THREAD_COUNT; ++i) {
+        threads.emplace_back([&short_queue] {
+            const auto deadline = std::chrono::steady_clock::now() + 400ms;
+            while (std::chrono::steady_clock::now() < deadline) {
+                short_queue.AddFindRequest("cat"s);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::this_thread::sleep_for(250ms);
+    Check(short_queue.GetStats().request_count == 0, "requests leave the window"s);
+    for (int i = 0; i < REQUEST_COUNT / 5; ++i) {
+        short_queue.AddFindRequest("bird"s);
+    }
+    const RequestStats short_stats = short_queue.GetStats();
+    Check(short_stats.request_count == REQUEST_COUNT / 5 && short_stats.no_result_count == REQUEST_COUNT / 5,
+          "reused buckets don't keep counts of older laps"s);
+}
+
+void TestCursorPagesCoverNearTies() {
+    SearchServer search_server("and"s);
+    constexpr int DOCUMENT_COUNT = 10;
+    for (int id = 1; id <= DOCUMENT_COUNT; ++id) {
+        search_server.AddDocument(id, "word"s, DocumentStatus::ACTUAL, {id});
+    }
+    // Neighbours are within RELEVANCE_EPSILON of each other, documents three ratings apart are not
+    const RatingBoostedRanking<TfIdfRanking> ranking{{}, -RELEVANCE_EPSILON * 0.4};
+    for (const size_t limit : {size_t{1}, size_t{3}}) {
+        std::vector<int> ids;
+        PageRequest page_request{0, limit, ""s};
+        // Bounded, so a cursor that goes back fails the check rather than loops
+        for (int page_count = 0; page_count <= DOCUMENT_COUNT; ++page_count) {
+            SearchPage page = search_server.FindTopDocuments(std::execution::seq, ranking, "word"s,
+                                                             [](int, DocumentStatus, int) { return true; },
+                                                             page_request);
+            for (const Document& document : page.documents) {
+                ids.push_back(document.id);
+            }
+            page_request.cursor = std::move(page.next_cursor);
+            if (page_request.cursor.empty()) {
+                break;
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        std::vector<int> expected_ids(DOCUMENT_COUNT);
+        std::iota(expected_ids.begin(), expected_ids.end(), 1);
+        Check(ids == expected_ids, "cursor pages return every document once"s);
+    }
+}
+
+void RunTests() {
+    TestMovedServerKeepsStopWords();
+    TestMovedServerKeepsFrozenVocabulary();
+    TestMoveSourceOutlivesTarget();
+    TestCopiedServerIsIndependent();
+    TestPhraseSyntaxNeedsPositionalIndex();
+    TestWildcardsAndAutocomplete();
+    TestOrdinalSearchSkipsRemovedDocuments();
+    TestBooleanQueriesAreOptIn();
+    TestBooleanQueriesKeepMinusWords();
+    TestRequestQueueCountsConcurrentRequests();
+    TestCursorPagesCoverNearTies();
+}
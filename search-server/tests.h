@@ -0,0 +1,16 @@
+#pragma once
+
+// Self-checks run by `search-server --test`; a failed check throws std::logic_error
+void TestMovedServerKeepsStopWords();
+void TestMovedServerKeepsFrozenVocabulary();
+void TestMoveSourceOutlivesTarget();
+void TestCopiedServerIsIndependent();
+void TestPhraseSyntaxNeedsPositionalIndex();
+void TestWildcardsAndAutocomplete();
+void TestOrdinalSearchSkipsRemovedDocuments();
+void TestBooleanQueriesAreOptIn();
+void TestBooleanQueriesKeepMinusWords();
+void TestRequestQueueCountsConcurrentRequests();
+void TestCursorPagesCoverNearTies();
+
+void RunTests();